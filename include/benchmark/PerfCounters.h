@@ -0,0 +1,55 @@
+#ifndef __PERFCOUNTERS_H__
+#define __PERFCOUNTERS_H__
+
+namespace cut
+{
+	enum PerfCounter
+	{
+		COUNTER_CYCLES,
+		COUNTER_INSTRUCTIONS,
+		COUNTER_L1D_MISSES,
+		COUNTER_LLC_MISSES,
+		COUNTER_BRANCH_MISSES,
+		COUNTER_COUNT
+	};
+
+	// Hardware performance counters for the calling thread, read with perf_event_open on Linux.
+	// Each counter is opened on its own, so ones the CPU or kernel doesn't offer are just left out,
+	// and everywhere else none are available. Counts are scaled up for the time the kernel had a
+	// counter switched out to share the hardware with others.
+	class PerfCounters
+	{
+	public:
+		PerfCounters();
+		~PerfCounters();
+
+		// Returns the number of counters opened. On failure, getError says why the first one
+		// couldn't be.
+		int open();
+		void close();
+
+		bool isAvailable(PerfCounter counter) const;
+		const char* getError() const;
+
+		// Counts between start and stop are added to the totals
+		void start();
+		void stop();
+		void reset();
+
+		// Total since reset, or -1 if the counter isn't available
+		long long get(PerfCounter counter) const;
+
+		static const char* getName(PerfCounter counter);
+
+	private:
+		int files[COUNTER_COUNT];
+
+		// Raw value, time enabled and time running at start
+		long long startValues[COUNTER_COUNT][3];
+		double totals[COUNTER_COUNT];
+
+		char error[128];
+	};
+}
+
+#endif /* __PERFCOUNTERS_H__ */
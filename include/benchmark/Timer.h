@@ -0,0 +1,10 @@
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+namespace cut
+{
+	// Seconds since an arbitrary fixed point, from the highest resolution clock available
+	double getTime();
+}
+
+#endif /* __TIMER_H__ */
@@ -0,0 +1,14 @@
+#ifndef __MATRIXBATCH_H__
+#define __MATRIXBATCH_H__
+
+#include "Vector4.h"
+#include "Matrix4.h"
+
+namespace cut
+{
+	// SSE versions of the Matrix4 functions in Matrix.h, with a scalar fallback
+	void multVector4Batch(const Matrix4* matrix, const Vector4* vectors, Vector4* result, int count);
+	void multMatrix4Simd(const Matrix4* first, const Matrix4* second, Matrix4* result);
+}
+
+#endif /* __MATRIXBATCH_H__ */
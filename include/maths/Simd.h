@@ -0,0 +1,10 @@
+#ifndef __SIMD_H__
+#define __SIMD_H__
+
+// SSE is used by the batched maths functions wherever the target guarantees it
+#if !defined(CUT_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define CUT_SSE 1
+#include <emmintrin.h>
+#endif
+
+#endif /* __SIMD_H__ */
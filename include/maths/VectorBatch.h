@@ -0,0 +1,19 @@
+#ifndef __VECTORBATCH_H__
+#define __VECTORBATCH_H__
+
+#include "Vector3.h"
+
+namespace cut
+{
+	// Array versions of the functions in Vector.h, four vectors at a time with SSE where available
+	void dot3Batch(const Vector3* first, const Vector3* second, float* result, int count);
+
+	void normalise3Batch(const Vector3* first, Vector3* result, int count);
+
+	void linePlaneCoefficientBatch(const Vector3* linePoints, const Vector3* lineDirs, const Vector3* planeNormal, const Vector3* planePoint, float* result, int count);
+
+	// Signed distance of each point from the plane, positive on the side the normal points to
+	void planeDistanceBatch(const Vector3* points, const Vector3* planeNormal, const Vector3* planePoint, float* result, int count);
+}
+
+#endif /* __VECTORBATCH_H__ */
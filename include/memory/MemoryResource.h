@@ -0,0 +1,124 @@
+#ifndef __MEMORYRESOURCE_H__
+#define __MEMORYRESOURCE_H__
+
+#include <stddef.h>
+#include <atomic>
+
+namespace cut
+{
+	// Where buffers come from, along the lines of std::pmr::memory_resource (which Visual Studio 2013
+	// doesn't have). Every resource counts the memory it hands out, safely across threads.
+	class MemoryResource
+	{
+	public:
+		static const size_t DEFAULT_ALIGNMENT = 16;
+
+		MemoryResource();
+		virtual ~MemoryResource();
+
+		void* allocate(size_t bytes, size_t alignment = DEFAULT_ALIGNMENT);
+		void deallocate(void* pointer, size_t bytes, size_t alignment = DEFAULT_ALIGNMENT);
+
+		// Bytes handed out and not yet given back, and the most there have been at once
+		long long getLiveBytes() const;
+		long long getPeakBytes() const;
+
+		long long getAllocationCount() const;
+		long long getDeallocationCount() const;
+
+		// Starts the peak again from the live bytes, to measure one stretch of work
+		void resetPeak();
+
+		// Plain new and delete, used by anything that isn't given a resource
+		static MemoryResource* getDefault();
+
+	protected:
+		virtual void* doAllocate(size_t bytes, size_t alignment) = 0;
+
+		// Returns false if the memory isn't given back yet, so it still counts as live
+		virtual bool doDeallocate(void* pointer, size_t bytes, size_t alignment) = 0;
+
+		void releaseLiveBytes(long long bytes);
+
+	private:
+		std::atomic<long long> liveBytes;
+		std::atomic<long long> peakBytes;
+		std::atomic<long long> allocationCount;
+		std::atomic<long long> deallocationCount;
+	};
+
+	class NewDeleteResource : public MemoryResource
+	{
+	protected:
+		void* doAllocate(size_t bytes, size_t alignment);
+		bool doDeallocate(void* pointer, size_t bytes, size_t alignment);
+	};
+
+	// Hands out memory from large blocks one after another and frees nothing until rewind or release,
+	// which free everything at once. Suits buffers that all die together, such as the halves cut in
+	// one frame. Not safe to use from several threads at once.
+	class MonotonicResource : public MemoryResource
+	{
+	public:
+		// Blocks come from upstream, or the default resource if that's null
+		MonotonicResource(size_t blockSize = 1 << 20, MemoryResource* upstream = nullptr);
+		~MonotonicResource();
+
+		// Both free everything. Rewind keeps the blocks to fill again, so a resource rewound every
+		// frame stops touching new memory once it has grown, and release gives them back upstream.
+		// Meshes holding memory from here must be emptied with Mesh::setMemoryResource or destroyed
+		// before they're used again.
+		void rewind();
+		void release();
+
+		size_t getBlockSize() const { return blockSize; }
+
+	protected:
+		void* doAllocate(size_t bytes, size_t alignment);
+		bool doDeallocate(void* pointer, size_t bytes, size_t alignment);
+
+	private:
+		struct Block
+		{
+			Block* next;
+			size_t size;
+		};
+
+		MemoryResource* upstream;
+		size_t blockSize;
+
+		// In the order they're filled, and the block being filled, or null before the first
+		Block* firstBlock;
+		Block* currentBlock;
+		char* current;
+		char* end;
+	};
+
+	// Arrays that remember their size in a header in front of them, so they can be given back to a
+	// resource with only the pointer, like delete[]. Only for types that need no construction.
+	const size_t ARRAY_HEADER_SIZE = MemoryResource::DEFAULT_ALIGNMENT;
+
+	template <typename T>
+	T* allocateArray(MemoryResource* resource, size_t count)
+	{
+		size_t bytes = ARRAY_HEADER_SIZE + count * sizeof(T);
+		char* memory = static_cast<char*>(resource->allocate(bytes));
+
+		*reinterpret_cast<size_t*>(memory) = bytes;
+
+		return reinterpret_cast<T*>(memory + ARRAY_HEADER_SIZE);
+	}
+
+	template <typename T>
+	void freeArray(MemoryResource* resource, T* array)
+	{
+		if (array == nullptr)
+			return;
+
+		char* memory = reinterpret_cast<char*>(array) - ARRAY_HEADER_SIZE;
+
+		resource->deallocate(memory, *reinterpret_cast<size_t*>(memory));
+	}
+}
+
+#endif /* __MEMORYRESOURCE_H__ */
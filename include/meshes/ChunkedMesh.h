@@ -0,0 +1,84 @@
+#ifndef __CHUNKEDMESH_H__
+#define __CHUNKEDMESH_H__
+
+#include "maths/Vector.h"
+#include "meshes/Mesh.h"
+
+#include <vector>
+
+namespace cut
+{
+	class ThreadPool;
+
+	// Part of a ChunkedMesh, with its own vertices and faces indexed locally into them. It owns
+	// its arrays, so it can't be copied.
+	struct MeshChunk
+	{
+		MeshChunk();
+		~MeshChunk();
+
+		MeshChunk(const MeshChunk&) = delete;
+		MeshChunk& operator=(const MeshChunk&) = delete;
+
+		Vector3* vertices;
+		Vector3* vertexNormals;
+		int vertexCount;
+
+		// 16 bit indices while the chunk has at most 65536 vertices and 32 bit after that, with
+		// the other null
+		unsigned short* shortIndices;
+		unsigned int* longIndices;
+		int indexCount;
+
+		int getIndex(int i) const { return shortIndices != nullptr ? (int)shortIndices[i] : (int)longIndices[i]; }
+	};
+
+	// Storage for meshes past the int counts of Mesh, such as large scans. Faces are kept in chunks
+	// of up to about CHUNK_VERTICES vertices with local indices, so totals are 64 bit and nothing
+	// needs one allocation for the whole mesh. Vertices used by faces in several chunks are copied
+	// into each, so the mesh isn't welded across chunks.
+	class ChunkedMesh
+	{
+	public:
+		static const int CHUNK_VERTICES = 65536;
+
+		ChunkedMesh();
+		~ChunkedMesh();
+
+		ChunkedMesh(const ChunkedMesh&) = delete;
+		ChunkedMesh& operator=(const ChunkedMesh&) = delete;
+
+		// Splits a mesh into chunks, keeping the faces in order. Normals are kept if it has them.
+		void fromMesh(const Mesh* mesh);
+
+		// Joins the chunks into one mesh, or returns false if the totals don't fit in a Mesh
+		bool toMesh(Mesh* mesh) const;
+
+		// Appends a chunk with room for these counts, for building very large meshes a piece at a
+		// time, and returns its index. The counts are filled in, and the indices are 16 bit if they
+		// can be.
+		int addChunk(int vertexCount, int indexCount, bool hasNormals);
+
+		void clear();
+
+		// Chunks are allocated one at a time, so these stay valid as more are added
+		int getChunkCount() const;
+		const MeshChunk* getChunk(int chunk) const;
+		MeshChunk* getChunk(int chunk);
+
+		long long getVertexCount() const;
+		long long getIndexCount() const;
+
+		// Cuts each chunk on its own, on the pool (or the shared pool if it is null), so the
+		// work and memory scale with the chunks. Each half keeps only the vertices its faces use,
+		// and chunks left with no faces are dropped. Intersections are interpolated in the same
+		// order whichever chunk they're in, so the halves match up across chunks. Either half can
+		// be null. Only options.epsilon is used.
+		void cut(ChunkedMesh* left, ChunkedMesh* right, Vector3 planePoint, Vector3 planeNormal, const CutOptions& options = CutOptions(), ThreadPool* pool = nullptr) const;
+
+	private:
+		std::vector<MeshChunk*> chunks;
+	};
+}
+
+#endif /* __CHUNKEDMESH_H__ */
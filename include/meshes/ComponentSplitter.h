@@ -0,0 +1,47 @@
+#ifndef __COMPONENTSPLITTER_H__
+#define __COMPONENTSPLITTER_H__
+
+#include <atomic>
+#include <vector>
+
+namespace cut
+{
+	class Mesh;
+	class ThreadPool;
+
+	// Separates a mesh into the pieces that share no vertices, such as the islands left on one
+	// side of a cut through a concave mesh. Vertices are grouped with a parallel union-find over
+	// the faces. The component meshes belong to the splitter and are refilled by the next split,
+	// reusing their arrays, so copy out any that need to be kept.
+	class ComponentSplitter
+	{
+	public:
+		// A null pool uses the shared default pool
+		ComponentSplitter(ThreadPool* pool = nullptr);
+		~ComponentSplitter();
+
+		// Returns the number of components, in order of their first face. Vertices not used by
+		// any face are dropped.
+		int split(const Mesh* mesh);
+
+		Mesh* getComponent(int component) const;
+		int getComponentCount() const;
+
+	private:
+		void reserve(int vertexCount);
+
+		ThreadPool* pool;
+
+		int vertexCapacity;
+		std::atomic<int>* parents;
+		int* componentIds;
+		int* localIndices;
+
+		std::vector<Mesh*> components;
+		std::vector<int> vertexCounts;
+		std::vector<int> faceCounts;
+		int componentCount;
+	};
+}
+
+#endif /* __COMPONENTSPLITTER_H__ */
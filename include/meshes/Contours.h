@@ -0,0 +1,30 @@
+#ifndef __CONTOURS_H__
+#define __CONTOURS_H__
+
+#include "maths/Vector.h"
+
+namespace cut
+{
+	// Cross section polylines for a set of parallel planes, produced by Mesh::slice.
+	// Polyline i is points[polylineStarts[i]] up to points[polylineStarts[i+1]], and
+	// layer k owns polylines layerStarts[k] up to layerStarts[k+1].
+	class Contours
+	{
+	public:
+		Contours();
+		~Contours();
+
+		void clear();
+
+		Vector3* points;
+		int* polylineStarts;
+		bool* polylineClosed;
+		int* layerStarts;
+
+		int pointCount;
+		int polylineCount;
+		int layerCount;
+	};
+}
+
+#endif /* __CONTOURS_H__ */
@@ -0,0 +1,91 @@
+#ifndef __CONVEXHULL_H__
+#define __CONVEXHULL_H__
+
+#include <vector>
+
+#include "maths/Vector.h"
+
+namespace cut
+{
+	class Mesh;
+
+	// Quickhull in 3D. Each step adds the point furthest outside the current hull, so when the
+	// number of hull vertices is capped the hull stops at the points that matter most. The
+	// workspace is kept between calls.
+	class ConvexHull
+	{
+	public:
+		ConvexHull();
+		~ConvexHull();
+
+		// Builds the hull of the points into hull, with at most maxVertices vertices if that
+		// isn't 0. Returns false, leaving hull empty, if the points are all on one plane.
+		bool build(const Vector3* points, int pointCount, Mesh* hull, int maxVertices = 0);
+
+		// The same for the vertices used by a mesh's faces, so a cut half only gives its own side
+		bool build(const Mesh* mesh, Mesh* hull, int maxVertices = 0);
+
+		// Builds the hull of one half of a cut without going through all of its vertices. The
+		// points used are the vertices of the source mesh's hull on the half's side of the plane
+		// and the half's intersection vertices, from firstNewVertex (the source vertex count) on.
+		// planeNormal must point into the half, so negate it for the right half. This misses only
+		// concave parts of the source that stick out past the old hull once the cut is made.
+		bool buildCutHull(const Mesh* sourceHull, const Mesh* half, int firstNewVertex, Vector3 planePoint, Vector3 planeNormal,
+			Mesh* hull, int maxVertices = 0);
+
+	private:
+		struct Candidate
+		{
+			float distance;
+			int face;
+
+			bool operator<(const Candidate& other) const { return distance < other.distance; }
+		};
+
+		struct Face
+		{
+			int vertices[3];
+			int neighbours[3];
+			Vector3 normal;
+			float offset;
+
+			// Points outside this face, as a list through outsideNext
+			int outsideHead;
+			int furthest;
+			float furthestDistance;
+
+			bool alive;
+		};
+
+		bool buildSimplex();
+		int addFace(int a, int b, int c);
+		void pushCandidate(int face);
+		float distance(int face, int point) const;
+		void assignOutside(int point, const int* candidates, int candidateCount);
+		void findHorizon(int firstFace, int eye);
+		void addPoint(int firstFace, int eye);
+		void writeMesh(Mesh* hull);
+
+		const Vector3* points;
+		int pointCount;
+		float epsilon;
+
+		std::vector<Face> faces;
+		std::vector<Candidate> heap;
+		std::vector<int> outsideNext;
+		std::vector<int> visible;
+		std::vector<int> horizonFrom;
+		std::vector<int> horizonTo;
+		std::vector<int> horizonFace;
+		std::vector<int> vertexFaces;
+		std::vector<int> newFaces;
+		std::vector<int> hullIndices;
+		std::vector<int> stack;
+		std::vector<int> faceMarks;
+		int mark;
+
+		std::vector<Vector3> seed;
+	};
+}
+
+#endif /* __CONVEXHULL_H__ */
@@ -0,0 +1,107 @@
+#ifndef __CUTCACHE_H__
+#define __CUTCACHE_H__
+
+#include "maths/Vector.h"
+#include "meshes/MassProperties.h"
+#include "meshes/Mesh.h"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace cut
+{
+	// Both halves of a cut, and their mass properties if the cut asked for them
+	struct CutResult
+	{
+		Mesh left;
+		Mesh right;
+
+		bool hasMass;
+		MassProperties leftMass;
+		MassProperties rightMass;
+	};
+
+	// Remembers the latest cuts of one mesh, so cutting it along the same plane again hands back the
+	// halves from before. Planes are compared by their unit normal and distance from the origin,
+	// rounded to normalStep and positionStep, so planes closer than that share the halves of the
+	// first of them to be cut. The least recently used cuts are dropped once there are more than
+	// maxEntries, or they hold more than maxBytes if that isn't 0, and every cut is dropped once
+	// the mesh's version changes. Building or clearing its adjacency doesn't change the version,
+	// so halves cut before keep the adjacency they had. Safe to use from several threads.
+	class CutCache
+	{
+	public:
+		CutCache(const Mesh* mesh, int maxEntries = 16, size_t maxBytes = 0, float positionStep = 1e-4f, float normalStep = 1e-4f);
+		~CutCache();
+
+		// Results stay valid for as long as they're held, whatever happens to the cache. The
+		// options are part of the key, and a decimator or optimiser in them is only used on a miss.
+		// If the options ask for mass properties they're filled in on hits too.
+		std::shared_ptr<const CutResult> cut(Vector3 planePoint, Vector3 planeNormal, const CutOptions& options = CutOptions());
+
+		void clear();
+
+		long long getHitCount() const;
+		long long getMissCount() const;
+		double getHitRate() const;
+
+		// Cuts held, and the bytes their halves take
+		int getEntryCount() const;
+		size_t getMemoryBytes() const;
+
+	private:
+		struct Key
+		{
+			int normal[3];
+			long long offset;
+
+			float epsilon;
+			int faceBudget;
+			float decimationError;
+			int flags;
+
+			bool operator==(const Key& other) const;
+		};
+
+		struct KeyHash
+		{
+			size_t operator()(const Key& key) const;
+		};
+
+		struct Entry
+		{
+			Key key;
+			std::shared_ptr<const CutResult> result;
+			size_t bytes;
+		};
+
+		typedef std::list<Entry> EntryList;
+
+		Key makeKey(Vector3 planePoint, Vector3 planeNormal, const CutOptions& options) const;
+
+		// Called with the mutex held
+		void checkVersion();
+		void evict();
+
+		const Mesh* mesh;
+		int maxEntries;
+		size_t maxBytes;
+		float positionStep;
+		float normalStep;
+
+		// Most recently used first
+		EntryList entries;
+		std::unordered_map<Key, EntryList::iterator, KeyHash> lookup;
+
+		unsigned int version;
+		size_t memoryBytes;
+		long long hitCount;
+		long long missCount;
+
+		mutable std::mutex mutex;
+	};
+}
+
+#endif /* __CUTCACHE_H__ */
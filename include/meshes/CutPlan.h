@@ -0,0 +1,51 @@
+#ifndef __CUTPLAN_H__
+#define __CUTPLAN_H__
+
+#include "maths/Vector.h"
+#include "meshes/TriangleSplit.h"
+
+namespace cut
+{
+	// The first stage of a cut: which side of the plane every vertex and face is on, without
+	// building anything. Made by Mesh::planCut and turned into halves by Mesh::materialiseCut,
+	// so a cut can be looked at and thrown away for the price of classifying it. The arrays are
+	// kept between plans.
+	class CutPlan
+	{
+	public:
+		CutPlan();
+		~CutPlan();
+
+		// Whether the plane divides the mesh, so that both halves would have faces
+		bool hitsMesh() const { return crossingFaceCount > 0 || (leftFaceCount > 0 && rightFaceCount > 0); }
+
+		// The plane, with the normal made unit length
+		Vector3 planePoint;
+		Vector3 planeNormal;
+
+		// The mesh size the plan was made for
+		int vertexCount;
+		int faceCount;
+
+		// Signed distance and side for each vertex
+		float* distances;
+		PlaneSide* vertexSides;
+
+		// The side each face is on, with faces lying in the plane already given to the half they
+		// face into. Faces the plane crosses are SIDE_ON, and are also listed in crossingFaces.
+		PlaneSide* faceSides;
+		int* crossingFaces;
+
+		int leftFaceCount;
+		int rightFaceCount;
+		int crossingFaceCount;
+
+		void reserve(int newVertexCount, int newFaceCount);
+
+	private:
+		int vertexCapacity;
+		int faceCapacity;
+	};
+}
+
+#endif /* __CUTPLAN_H__ */
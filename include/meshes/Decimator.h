@@ -0,0 +1,69 @@
+#ifndef __DECIMATOR_H__
+#define __DECIMATOR_H__
+
+#include <float.h>
+#include <vector>
+
+namespace cut
+{
+	class Mesh;
+
+	// Quadric error edge collapse. Vertices only ever collapse onto a neighbour, so no new
+	// positions are made, and open boundaries (such as the outline of a cut) carry a heavy
+	// penalty so they are kept. The workspace is kept between calls.
+	class Decimator
+	{
+	public:
+		Decimator();
+		~Decimator();
+
+		// Collapses edges until the mesh has at most targetFaceCount faces or nothing more can
+		// be collapsed. Only vertices on faces that use a vertex at or after firstCandidateVertex
+		// are removed, so passing the source vertex count of a cut limits it to the cut line.
+		// Collapses that would move the surface further than maxError on average are not made.
+		// Unused vertices are compacted away afterwards, keeping their order.
+		void decimate(Mesh* mesh, int targetFaceCount, int firstCandidateVertex = 0, float maxError = FLT_MAX);
+
+	private:
+		struct Collapse
+		{
+			float cost;
+			int from, to;
+			int fromVersion, toVersion;
+
+			bool operator<(const Collapse& other) const { return cost > other.cost; }
+		};
+
+		void reserve(int vertexCount, int faceCount);
+
+		const double* getQuadric(const Mesh* mesh, int vertex);
+		int countFacesWith(const Mesh* mesh, int vertex, int other);
+		void pushCollapses(const Mesh* mesh, int vertex);
+		void pushCollapse(const Mesh* mesh, int from, int to);
+		bool canCollapse(const Mesh* mesh, int from, int to);
+
+		int vertexCapacity;
+		int faceCapacity;
+
+		// Faces around each vertex. A collapsed vertex's list is chained onto the vertex it
+		// collapsed into, so the faces around a vertex are those in every list on its chain.
+		int* adjacencyStarts;
+		int* adjacency;
+		int* chainNext;
+		int* chainTail;
+
+		double* quadrics;
+		bool* quadricReady;
+		bool* removed;
+		bool* inRegion;
+		int* versions;
+		int* marks;
+		int mark;
+
+		bool* alive;
+
+		std::vector<Collapse> heap;
+	};
+}
+
+#endif /* __DECIMATOR_H__ */
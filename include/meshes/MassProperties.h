@@ -0,0 +1,41 @@
+#ifndef __MASSPROPERTIES_H__
+#define __MASSPROPERTIES_H__
+
+#include "maths/Matrix3.h"
+#include "maths/Vector3.h"
+
+namespace cut
+{
+	// Properties of a solid of unit density. The inertia tensor is about the centre of mass.
+	struct MassProperties
+	{
+		float volume;
+		Vector3 centreOfMass;
+		Matrix3 inertia;
+	};
+
+	// Sums the volume integrals under a closed surface one triangle at a time, as signed
+	// tetrahedra from an origin. Triangles lying in a plane through the origin add nothing, so
+	// with the origin on a cutting plane a half that was cut open along it comes out the same as
+	// the solid closed off with a flat cap, without the cap having to be built.
+	class MassAccumulator
+	{
+	public:
+		MassAccumulator(Vector3 origin);
+
+		void addTriangle(const Vector3* a, const Vector3* b, const Vector3* c);
+
+		void getProperties(MassProperties* result) const;
+
+	private:
+		Vector3 origin;
+
+		// Six times the volume, 24 times the first moments and 120 times the second moments
+		// (xx, yy, zz, xy, yz, zx), all about the origin
+		double volume;
+		double moments[3];
+		double products[6];
+	};
+}
+
+#endif /* __MASSPROPERTIES_H__ */
@@ -1,21 +1,113 @@
 #ifndef __MESH_H__
 #define __MESH_H__
 
+#include "maths/Matrix4.h"
 #include "maths/Vector.h"
 
 namespace cut
 {
+	class Contours;
+	class CutPlan;
+	class Decimator;
+	struct MassProperties;
+	class MemoryResource;
+	class MeshBvh;
+	struct SkinWeights;
+	class ThreadPool;
+	class VertexCacheOptimiser;
+
+	struct CutOptions
+	{
+		CutOptions();
+
+		// Vertices closer to the plane than this are treated as lying on it, so faces that
+		// only graze the plane aren't split into slivers
+		float epsilon;
+
+		// If a decimator is set, halves with more than faceBudget faces are decimated. Edges around
+		// the cut line go first, as long as they move the surface less than decimationError, and
+		// then the whole half if that isn't enough.
+		Decimator* decimator;
+		int faceBudget;
+		float decimationError;
+
+		// If set, both halves are reordered for the vertex cache after cutting
+		VertexCacheOptimiser* optimiser;
+
+		// If set, filled with the mass properties of each half as a solid closed off at the cut,
+		// taken from the faces as they are written, before any decimation
+		MassProperties* leftMass;
+		MassProperties* rightMass;
+	};
+
 	class Mesh
 	{
 	public:
-		Mesh();
+		// The arrays come from resource, or the default one if that's null
+		Mesh(MemoryResource* resource = nullptr);
 		~Mesh();
 
 		void createCube();
-		void loadObj(const char* filename);
-		void loadObjOld(const char* filename);
+		void createIcosphere(int frequency);
+		void createGrid(int columns, int rows);
+		void createTerrain(int columns, int rows, float height, unsigned int seed);
+		void createSoup(int componentCount, unsigned int seed);
+
+		// With spatialOrder, the mesh is put through reorderSpatially as it's loaded
+		void loadObj(const char* filename, bool spatialOrder = false);
+		void loadObjOld(const char* filename, bool spatialOrder = false);
+
+		// Loads obj text that is already in memory, without calculating normals. The text is
+		// null terminated and is split into lines in place. See MeshLoader for loading many files.
+		void parseObj(char* text);
+
+		void calculateNormals();
+
+		// Sorts the vertices along a Morton curve through the bounding box, and the faces by where
+		// their centroids fall on it, so that faces close together in space are close together in
+		// memory and a cut's vertex fetches walk it nearly in order. Scans and converted files
+		// often come in no such order. Clears the adjacency.
+		void reorderSpatially();
+
+		// Treats the mesh as a closed solid of unit density
+		void calculateMassProperties(MassProperties* result) const;
+
+		// Builds the convex hull of the vertices used by the faces, with at most maxVertices vertices if that
+		// isn't 0. See ConvexHull for reusing the workspace and for hulls of cut halves.
+		bool calculateConvexHull(Mesh* hull, int maxVertices = 0) const;
+
+		void cut(Mesh* left, Mesh* right, Vector3 planePoint, Vector3 planeNormal, const CutOptions& options = CutOptions());
+
+		// The same cut in two stages. planCut only classifies the vertices and faces, so the
+		// plan can be checked (which half is bigger, whether the plane hits at all) before
+		// materialiseCut builds the halves from it. Either half can be null to skip building it.
+		// The mesh mustn't change in between.
+		void planCut(CutPlan* plan, Vector3 planePoint, Vector3 planeNormal, const CutOptions& options = CutOptions()) const;
+		void materialiseCut(const CutPlan* plan, Mesh* left, Mesh* right, const CutOptions& options = CutOptions()) const;
 
-		void cut(Mesh* left, Mesh* right, Vector3 planePoint, Vector3 planeNormal);
+		// Cuts the mesh as posed by a skeleton, taking it to be in its bind pose with skin's
+		// weights for each vertex. Vertices and normals are skinned with palette as their
+		// distances to the plane are measured, so the posed mesh is never built on its own and
+		// the halves come out posed. See Skinning.h.
+		void cutSkinned(Mesh* left, Mesh* right, const SkinWeights* skin, const Matrix4* palette, Vector3 planePoint, Vector3 planeNormal, const CutOptions& options = CutOptions()) const;
+
+		// Keeps the part of the mesh on the left of every plane (the side the normals point to),
+		// such as the inside of a box or frustum, in one pass instead of a cut per plane. Faces
+		// inside or outside everything are copied or dropped straight away, and only the used
+		// vertices go into result, with normals and texture coordinates interpolated. Returns
+		// false if there are more than MAX_CLIP_PLANES planes or result is this mesh.
+		static const int MAX_CLIP_PLANES = 32;
+
+		bool clipConvex(Mesh* result, const Vector3* planePoints, const Vector3* planeNormals, int planeCount, const CutOptions& options = CutOptions()) const;
+
+		// Cuts along a knife stroke rather than a whole plane: the segment from segmentStart to
+		// segmentEnd swept along sweep. Only faces the stroke passes through are split, in place,
+		// and the bvh is used to find them and updated with the new pieces. Returns the number of
+		// faces split.
+		int knifeCut(MeshBvh* bvh, Vector3 segmentStart, Vector3 segmentEnd, Vector3 sweep, const CutOptions& options = CutOptions());
+
+		// Cross sections at layerCount planes spaced along the normal, starting at planePoint
+		void slice(Contours* contours, Vector3 planePoint, Vector3 planeNormal, float spacing, int layerCount, ThreadPool* pool = nullptr) const;
 
 		Vector3* vertices;
 		int* indices;
@@ -24,6 +116,52 @@ namespace cut
 	
 		int vertexCount;
 		int indexCount;
+
+		// Allocated sizes of the arrays, which can be more than the counts
+		int vertexCapacity;
+		int indexCapacity;
+
+		// Makes room for at least this many vertices and indices, keeping the current contents
+		void reserve(int newVertexCount, int newIndexCount);
+
+		// Replaces result's contents with a copy of this mesh, allocated from result's resource
+		void copyTo(Mesh* result) const;
+
+		// Half edge adjacency, optional. The half edge at corner i runs from indices[i] to the next
+		// corner of its face, and opposites[i] is the corner of the half edge running the other way
+		// along the same edge, or -1 on a boundary. Cuts keep it up to date in both halves;
+		// anything else that changes the faces clears it. Building or clearing it doesn't change
+		// the version below, as the geometry stays the same.
+		int* opposites;
+
+		void buildAdjacency();
+		void clearAdjacency();
+
+		static int nextCorner(int corner) { return corner - corner % 3 + (corner % 3 + 1) % 3; }
+
+		// Counts changes, so results worked out from the mesh (see CutCache) can tell when they're
+		// stale. Everything here that changes the mesh counts itself, and code that changes the
+		// arrays directly should call markChanged.
+		unsigned int getVersion() const { return version; }
+		void markChanged() { version++; }
+
+		// Anything that replaces one of the arrays above must allocate and free it with
+		// allocateArray and freeArray on this resource
+		MemoryResource* getMemoryResource() const { return resource; }
+
+		// Empties the mesh, and takes the arrays from resource (or the default one) from then on
+		void setMemoryResource(MemoryResource* resource);
+
+	private:
+		void release();
+
+		// The face half of planCut and the whole of materialiseCut, with the vertex positions and
+		// normals taken from the given arrays rather than the mesh's own
+		void classifyFaces(CutPlan* plan, const Vector3* positions) const;
+		void materialiseCutFrom(const CutPlan* plan, const Vector3* sourceVertices, const Vector3* sourceNormals, Mesh* left, Mesh* right, const CutOptions& options) const;
+
+		MemoryResource* resource;
+		unsigned int version;
 	};
 }
 
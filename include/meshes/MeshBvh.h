@@ -0,0 +1,45 @@
+#ifndef __MESHBVH_H__
+#define __MESHBVH_H__
+
+#include <vector>
+
+#include "maths/Vector.h"
+
+namespace cut
+{
+	class Mesh;
+
+	// Bounding volume hierarchy over the faces of a mesh. When a face is split in place its
+	// pieces are chained to it, and since they lie inside it its bounds still hold, so the tree
+	// stays valid through knife cuts. Anything else that changes the faces needs a rebuild.
+	class MeshBvh
+	{
+	public:
+		MeshBvh();
+
+		void build(const Mesh* mesh);
+
+		// Appends the faces (and pieces of them) in every leaf that overlaps the box, so a few may
+		// lie just outside it
+		void query(const Vector3* boxMin, const Vector3* boxMax, std::vector<int>* faces) const;
+
+		// Records that piece was split off face
+		void addPiece(int face, int piece);
+
+	private:
+		// Leaves have a face count, and interior nodes have their children at first and first + 1
+		struct Node
+		{
+			Vector3 boundsMin;
+			Vector3 boundsMax;
+			int first;
+			int faceCount;
+		};
+
+		std::vector<Node> nodes;
+		std::vector<int> faceOrder;
+		std::vector<int> nextPiece;
+	};
+}
+
+#endif /* __MESHBVH_H__ */
@@ -0,0 +1,34 @@
+#ifndef __MESHLOADER_H__
+#define __MESHLOADER_H__
+
+#include <stddef.h>
+
+namespace cut
+{
+	class Mesh;
+	class ThreadPool;
+
+	// Seconds spent on each stage of loading a file, and how long after the batch started
+	// the mesh was ready
+	struct LoadTiming
+	{
+		double readTime;
+		double parseTime;
+		double normalsTime;
+		double readyTime;
+	};
+
+	// Reads a whole file into a null terminated buffer to free with delete[], or returns null if
+	// it can't be read. length can be null.
+	char* readTextFile(const char* filename, size_t* length);
+
+	// Loads count obj files into meshes at once. Files are read one after another on the calling
+	// thread, keeping the disk busy, and each is parsed and has its normals calculated on the pool
+	// (or the shared pool if it is null) while the next ones are read. Only a few files are held
+	// in memory at a time, and the calling thread parses too when the pool falls behind. Meshes
+	// whose files can't be read are left empty. The meshes mustn't share a memory resource
+	// that isn't safe across threads. timings can be null. Returns the number of files loaded.
+	int loadObjBatch(const char* const* filenames, Mesh* meshes, LoadTiming* timings, int count, ThreadPool* pool = nullptr);
+}
+
+#endif /* __MESHLOADER_H__ */
@@ -0,0 +1,46 @@
+#ifndef __MESHLODS_H__
+#define __MESHLODS_H__
+
+#include "meshes/Decimator.h"
+
+#include <vector>
+
+namespace cut
+{
+	class Mesh;
+
+	// Simplified copies of a mesh for quick previews, such as cuts while a knife is being dragged.
+	// Level 0 is the mesh itself, and each level after it is decimated from the one before to
+	// about ratio of its faces, down to minFaceCount. Building them is slow, so it's best done
+	// when the mesh is loaded.
+	class MeshLods
+	{
+	public:
+		MeshLods();
+		~MeshLods();
+
+		// The mesh must outlive the levels
+		void build(const Mesh* mesh, float ratio = 0.25f, int minFaceCount = 10000, int maxLevelCount = 8);
+
+		// Including level 0
+		int getLevelCount() const;
+		const Mesh* getLevel(int level) const;
+
+		// The finest level with at most maxFaceCount faces, or the coarsest if none are that small
+		int findLevel(int maxFaceCount) const;
+
+		// False once the mesh has changed since the levels were built
+		bool isCurrent() const;
+
+	private:
+		void release();
+
+		const Mesh* mesh;
+		unsigned int version;
+
+		std::vector<Mesh*> levels;
+		Decimator decimator;
+	};
+}
+
+#endif /* __MESHLODS_H__ */
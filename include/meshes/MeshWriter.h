@@ -0,0 +1,33 @@
+#ifndef __MESHWRITER_H__
+#define __MESHWRITER_H__
+
+namespace cut
+{
+	class Mesh;
+	class ThreadPool;
+
+	enum MeshFormat
+	{
+		FORMAT_PLY,
+		FORMAT_STL,
+		FORMAT_GLB
+	};
+
+	// Binary writers that copy the mesh arrays out as they are, so a cut half goes to disk
+	// without any text formatting. Arrays that already have the file's layout are written
+	// directly, and the rest go through a fixed size staging buffer. Vertices are written
+	// whether or not faces use them, keeping the indices as they are. Faces are turned round to
+	// the counter-clockwise winding the formats expect. Files are little endian, like the
+	// machines this runs on. saveGlb returns false for a mesh with no faces, such as an empty cut
+	// half, as glTF can't hold one, and for files past the container's 4 GiB limit.
+	bool savePly(const Mesh* mesh, const char* filename);
+	bool saveStl(const Mesh* mesh, const char* filename);
+	bool saveGlb(const Mesh* mesh, const char* filename);
+
+	bool saveMesh(const Mesh* mesh, const char* filename, MeshFormat format);
+
+	// Writes both halves of a cut at once on the pool, or the shared pool if it is null
+	bool saveHalves(const Mesh* left, const char* leftFile, const Mesh* right, const char* rightFile, MeshFormat format, ThreadPool* pool = nullptr);
+}
+
+#endif /* __MESHWRITER_H__ */
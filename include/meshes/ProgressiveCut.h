@@ -0,0 +1,65 @@
+#ifndef __PROGRESSIVECUT_H__
+#define __PROGRESSIVECUT_H__
+
+#include "maths/Vector.h"
+#include "meshes/Mesh.h"
+
+#include <memory>
+#include <mutex>
+
+namespace cut
+{
+	class MeshLods;
+	class ThreadPool;
+
+	// The halves of a cut and the level of detail they were cut from, 0 being full resolution
+	struct LodCutResult
+	{
+		Mesh left;
+		Mesh right;
+
+		int level;
+	};
+
+	// Cuts the coarsest level of a mesh straight away for a preview, and the full mesh on the pool
+	// afterwards to replace it. While the full cut runs, further cuts only keep the latest plane
+	// waiting, so dragging a knife previews every frame without queueing up full cuts that are
+	// already out of date. Only options.epsilon is used, since the full cut runs on another thread.
+	class ProgressiveCut
+	{
+	public:
+		// A null pool uses the shared default pool
+		ProgressiveCut(const MeshLods* lods, ThreadPool* pool = nullptr);
+
+		// Waits for a full cut in progress on another thread, dropping one that hasn't started
+		~ProgressiveCut();
+
+		// Returns the preview, which is also the result until the full cut for this plane is done.
+		// Returns null if the levels haven't been built.
+		std::shared_ptr<const LodCutResult> cut(Vector3 planePoint, Vector3 planeNormal, const CutOptions& options = CutOptions());
+
+		// The latest plane's full cut if it's done, and its preview otherwise
+		std::shared_ptr<const LodCutResult> getResult() const;
+
+		bool isRefined() const;
+
+		// Waits until the latest plane's full cut is done. If no task has taken it yet, it's cut
+		// on the calling thread, so this doesn't deadlock when called from a pool task while
+		// every other thread is busy.
+		void wait();
+
+	private:
+		struct RefineState;
+
+		static void refine(RefineState* state, const MeshLods* lods, std::unique_lock<std::mutex>* lock);
+
+		const MeshLods* lods;
+		ThreadPool* pool;
+
+		// Shared with the pool task, so a task that starts after the destructor finds nothing to
+		// do and never touches this object
+		std::shared_ptr<RefineState> state;
+	};
+}
+
+#endif /* __PROGRESSIVECUT_H__ */
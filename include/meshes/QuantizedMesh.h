@@ -0,0 +1,49 @@
+#ifndef __QUANTIZEDMESH_H__
+#define __QUANTIZEDMESH_H__
+
+#include "maths/Vector.h"
+#include "meshes/Mesh.h"
+
+namespace cut
+{
+	// A compact copy of a mesh for cutting with less memory traffic. Positions are 16 bit steps
+	// across the bounding box and normals are 16 bit octahedral coordinates, 10 bytes a vertex
+	// instead of 24. Texture coordinates and adjacency aren't kept.
+	class QuantizedMesh
+	{
+	public:
+		QuantizedMesh();
+		~QuantizedMesh();
+
+		void quantize(const Mesh* mesh);
+		void dequantize(Mesh* mesh) const;
+
+		// Cuts like Mesh::cut, classifying the quantized positions directly against the plane
+		// moved into quantized space. Intersections are rounded to the nearest step, and both
+		// halves keep this mesh's bounding box. Only options.epsilon is used.
+		void cut(QuantizedMesh* left, QuantizedMesh* right, Vector3 planePoint, Vector3 planeNormal, const CutOptions& options = CutOptions()) const;
+
+		void getPosition(int vertex, Vector3* result) const;
+		void getNormal(int vertex, Vector3* result) const;
+
+		static void encodeNormal(const Vector3* normal, short* result);
+		static void decodeNormal(const short* encoded, Vector3* result);
+
+		// A position is boundsMin + quantized * step, per axis
+		Vector3 boundsMin;
+		Vector3 step;
+
+		// Three per vertex, and two per vertex for normals, which can be null
+		unsigned short* positions;
+		short* normals;
+		int* indices;
+
+		int vertexCount;
+		int indexCount;
+
+	private:
+		void release();
+	};
+}
+
+#endif /* __QUANTIZEDMESH_H__ */
@@ -0,0 +1,62 @@
+#ifndef __SKINNING_H__
+#define __SKINNING_H__
+
+#include "maths/Matrix4.h"
+#include "maths/Vector.h"
+
+#include <math.h>
+
+namespace cut
+{
+	// Bones that can move each vertex
+	const int SKIN_INFLUENCES = 4;
+
+	// Bone influences for the vertices of a mesh in its bind pose, SKIN_INFLUENCES to a vertex.
+	// Weights should add up to 1, and influences that aren't used have a weight of 0.
+	struct SkinWeights
+	{
+		const unsigned short* boneIndices;
+		const float* boneWeights;
+	};
+
+	// Poses one vertex and its normal with the weighted sum of its bones' matrices. Matrices are
+	// column major like the rest of the maths library, and transform normals too, so they
+	// shouldn't scale unevenly. The normal is made unit length again afterwards.
+	inline void skinVertex(const Vector3* vertex, const Vector3* normal, const unsigned short* bones, const float* weights, const Matrix4* palette, Vector3* result, Vector3* resultNormal)
+	{
+		Vector3 position = { 0, 0, 0 };
+		Vector3 direction = { 0, 0, 0 };
+
+		for (int i = 0; i < SKIN_INFLUENCES; ++i)
+		{
+			float weight = weights[i];
+
+			if (weight == 0)
+				continue;
+
+			const float* m = palette[bones[i]].data;
+
+			position.x += weight * (m[0] * vertex->x + m[4] * vertex->y + m[8] * vertex->z + m[12]);
+			position.y += weight * (m[1] * vertex->x + m[5] * vertex->y + m[9] * vertex->z + m[13]);
+			position.z += weight * (m[2] * vertex->x + m[6] * vertex->y + m[10] * vertex->z + m[14]);
+
+			direction.x += weight * (m[0] * normal->x + m[4] * normal->y + m[8] * normal->z);
+			direction.y += weight * (m[1] * normal->x + m[5] * normal->y + m[9] * normal->z);
+			direction.z += weight * (m[2] * normal->x + m[6] * normal->y + m[10] * normal->z);
+		}
+
+		float length = sqrtf(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+
+		if (length > 0)
+		{
+			direction.x /= length;
+			direction.y /= length;
+			direction.z /= length;
+		}
+
+		*result = position;
+		*resultNormal = direction;
+	}
+}
+
+#endif /* __SKINNING_H__ */
@@ -0,0 +1,100 @@
+#ifndef __STREAMINGCUT_H__
+#define __STREAMINGCUT_H__
+
+#include <stdio.h>
+
+#include "maths/Vector.h"
+#include "meshes/Mesh.h"
+
+namespace cut
+{
+	// Writes a mesh in the binary format read by StreamingCutter: "SMSH", a 32 bit version,
+	// 64 bit vertex and face counts, then packed float positions and 32 bit triangle indices
+	bool saveStreamMesh(const Mesh* mesh, const char* filename);
+
+	// Cuts meshes that don't fit in memory. Faces are read from an obj or stream mesh file in
+	// fixed size chunks, split, and each half is appended to its own obj file as it goes.
+	// Memory use is bounded by the chunk size, the vertex page cache and the remap windows.
+	class StreamingCutter
+	{
+	public:
+		StreamingCutter(int chunkFaces = 65536, int windowSize = 1 << 18, int cachePages = 256);
+		~StreamingCutter();
+
+		// Returns false if a file can't be read or written, or the input has a polygon with more
+		// corners than a chunk is sized for. getError then says which. The vertex file spilled
+		// while reading an obj is removed either way.
+		bool cut(const char* inputFile, const char* leftFile, const char* rightFile, Vector3 planePoint, Vector3 planeNormal, const CutOptions& options = CutOptions());
+		const char* getError() const;
+
+		long long facesRead;
+		long long leftFaceCount;
+		long long rightFaceCount;
+		long long leftVertexCount;
+		long long rightVertexCount;
+
+	private:
+		struct RemapSlot
+		{
+			long long source;
+			long long output;
+		};
+
+		struct EdgeSlot
+		{
+			long long a, b;
+			long long output;
+		};
+
+		struct Half
+		{
+			FILE* file;
+			long long vertexCount;
+			long long faceCount;
+			RemapSlot* remap;
+			EdgeSlot* edges;
+		};
+
+		bool openHalf(Half* half, const char* filename);
+		bool closeHalf(Half* half);
+
+		const Vector3* fetchVertex(long long index);
+		long long emitVertex(Half* half, long long index);
+		long long emitIntersection(Half* half, long long a, long long b, float t);
+		void emitFace(Half* half, long long a, long long b, long long c);
+
+		bool convertObjVertices(FILE* input, const char* vertexFile);
+		int readObjFaces(FILE* input, long long* vertexCountSoFar);
+		int readBinaryFaces(FILE* input, long long facesLeft);
+		void cutChunk(int faceCount, Vector3 planePoint, Vector3 planeNormal, float epsilon);
+
+		int chunkFaces;
+		int windowSize;
+		int cachePages;
+
+		// Current chunk
+		long long* chunkIndices;
+		Vector3* chunkPositions;
+		float* chunkDistances;
+		unsigned int* binaryFaces;
+
+		// Vertex page cache over the vertex region of the file
+		FILE* vertexSource;
+		long long vertexOffset;
+		long long vertexTotal;
+		Vector3* pages;
+		long long* pageTags;
+		bool* pageUsed;
+		int* pageSlots;
+		int clockHand;
+
+		Half left, right;
+
+		char* lineBuffer;
+
+		// Why the last cut failed, or null
+		const char* error;
+	};
+}
+
+#endif /* __STREAMINGCUT_H__ */
@@ -0,0 +1,101 @@
+#ifndef __TRIANGLESPLIT_H__
+#define __TRIANGLESPLIT_H__
+
+namespace cut
+{
+	// Which side of a cutting plane a vertex is on. Left is the side the normal points to.
+	enum PlaneSide
+	{
+		SIDE_LEFT = 0,
+		SIDE_RIGHT = 1,
+		SIDE_ON = 2
+	};
+
+	// Vertices within epsilon of the plane are on it, and are shared by both halves
+	inline PlaneSide classifyDistance(float distance, float epsilon)
+	{
+		if (distance > epsilon)
+			return SIDE_LEFT;
+		else if (distance < -epsilon)
+			return SIDE_RIGHT;
+
+		return SIDE_ON;
+	}
+
+	// The triangles a face splits into. Corners 0-2 are the corners of the face, and
+	// SPLIT_EDGE + k is the intersection on the edge from corner k to corner (k+1) % 3.
+	const int SPLIT_EDGE = 3;
+
+	struct TriangleSplit
+	{
+		int triangleCount;
+		PlaneSide sides[3];
+		int corners[3][3];
+	};
+
+	// Works out how a face is divided given the sides of its corners, keeping its winding.
+	// A face lying entirely on the plane comes back whole with SIDE_ON, for the caller to place.
+	inline void splitTriangle(const PlaneSide sides[3], TriangleSplit* result)
+	{
+		int pointsToLeft = (sides[0] == SIDE_LEFT ? 1 : 0) + (sides[1] == SIDE_LEFT ? 1 : 0) + (sides[2] == SIDE_LEFT ? 1 : 0);
+		int pointsToRight = (sides[0] == SIDE_RIGHT ? 1 : 0) + (sides[1] == SIDE_RIGHT ? 1 : 0) + (sides[2] == SIDE_RIGHT ? 1 : 0);
+
+		// Nothing on the far side, so the face stays whole
+		if (pointsToLeft == 0 || pointsToRight == 0)
+		{
+			result->triangleCount = 1;
+			result->sides[0] = pointsToLeft > 0 ? SIDE_LEFT : (pointsToRight > 0 ? SIDE_RIGHT : SIDE_ON);
+			result->corners[0][0] = 0;
+			result->corners[0][1] = 1;
+			result->corners[0][2] = 2;
+			return;
+		}
+
+		// One corner on the plane: split through it into one triangle per side
+		if (pointsToLeft + pointsToRight == 2)
+		{
+			int a = sides[0] == SIDE_ON ? 0 : (sides[1] == SIDE_ON ? 1 : 2);
+			int b = (a + 1) % 3;
+			int c = (a + 2) % 3;
+
+			result->triangleCount = 2;
+
+			result->sides[0] = sides[b];
+			result->corners[0][0] = a;
+			result->corners[0][1] = b;
+			result->corners[0][2] = SPLIT_EDGE + b;
+
+			result->sides[1] = sides[c];
+			result->corners[1][0] = a;
+			result->corners[1][1] = SPLIT_EDGE + b;
+			result->corners[1][2] = c;
+			return;
+		}
+
+		// One corner alone on its side: a triangle on that side and a quad on the other
+		PlaneSide lone = pointsToLeft == 1 ? SIDE_LEFT : SIDE_RIGHT;
+
+		int a = sides[0] == lone ? 0 : (sides[1] == lone ? 1 : 2);
+		int b = (a + 1) % 3;
+		int c = (a + 2) % 3;
+
+		result->triangleCount = 3;
+
+		result->sides[0] = lone;
+		result->corners[0][0] = a;
+		result->corners[0][1] = SPLIT_EDGE + a;
+		result->corners[0][2] = SPLIT_EDGE + c;
+
+		result->sides[1] = sides[b];
+		result->corners[1][0] = SPLIT_EDGE + a;
+		result->corners[1][1] = b;
+		result->corners[1][2] = c;
+
+		result->sides[2] = sides[b];
+		result->corners[2][0] = SPLIT_EDGE + a;
+		result->corners[2][1] = c;
+		result->corners[2][2] = SPLIT_EDGE + c;
+	}
+}
+
+#endif /* __TRIANGLESPLIT_H__ */
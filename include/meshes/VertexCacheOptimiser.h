@@ -0,0 +1,52 @@
+#ifndef __VERTEXCACHEOPTIMISER_H__
+#define __VERTEXCACHEOPTIMISER_H__
+
+#include "maths/Vector.h"
+
+namespace cut
+{
+	class Mesh;
+
+	// Reorders meshes for rendering: faces for post-transform vertex cache hits (Tipsify), then
+	// vertices into the order the faces first use them. Both passes are linear time, and the
+	// workspace is kept between calls so one optimiser can be reused after every cut.
+	class VertexCacheOptimiser
+	{
+	public:
+		VertexCacheOptimiser(int cacheSize = 16);
+		~VertexCacheOptimiser();
+
+		void optimise(Mesh* mesh);
+
+		// Reorders the faces of an index buffer in place
+		void optimiseFaces(int* indices, int indexCount, int vertexCount);
+
+		// Renumbers vertices by first use, dropping unused ones, and returns the new count.
+		// Any of the attribute arrays can be null.
+		int optimiseVertices(int* indices, int indexCount, int vertexCount, Vector3* vertices, Vector3* normals, Vector2* texCoords);
+
+	private:
+		void reserve(int vertexCount, int indexCount);
+
+		int cacheSize;
+
+		// Per vertex
+		int vertexCapacity;
+		int* adjacencyStarts;
+		int* liveCounts;
+		int* cacheTimes;
+		int* remap;
+		Vector3* vectorScratch;
+		Vector2* texCoordScratch;
+
+		// Per index
+		int indexCapacity;
+		int* adjacency;
+		int* candidates;
+		int* deadEnds;
+		int* output;
+		bool* emitted;
+	};
+}
+
+#endif /* __VERTEXCACHEOPTIMISER_H__ */
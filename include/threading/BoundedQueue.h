@@ -0,0 +1,78 @@
+#ifndef __BOUNDEDQUEUE_H__
+#define __BOUNDEDQUEUE_H__
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace cut
+{
+	// Queue between the stages of a pipeline. push waits while it holds capacity items, so a
+	// fast stage can only get that far ahead of a slow one, and pop waits while it is empty.
+	// Once closed, pops take what is left and then fail, so the next stage knows to stop.
+	template <typename T>
+	class BoundedQueue
+	{
+	public:
+		BoundedQueue(int capacity)
+			: capacity(capacity > 0 ? capacity : 1), closed(false)
+		{
+
+		}
+
+		// Returns false without adding the item if the queue has been closed
+		bool push(const T& item)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			while (!closed && (int)items.size() >= capacity)
+				notFull.wait(lock);
+
+			if (closed)
+				return false;
+
+			items.push_back(item);
+			notEmpty.notify_one();
+
+			return true;
+		}
+
+		// Returns false once the queue is closed and empty
+		bool pop(T* item)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			while (!closed && items.empty())
+				notEmpty.wait(lock);
+
+			if (items.empty())
+				return false;
+
+			*item = items.front();
+			items.pop_front();
+			notFull.notify_one();
+
+			return true;
+		}
+
+		void close()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			closed = true;
+			notEmpty.notify_all();
+			notFull.notify_all();
+		}
+
+	private:
+		std::deque<T> items;
+		int capacity;
+		bool closed;
+
+		std::mutex mutex;
+		std::condition_variable notEmpty;
+		std::condition_variable notFull;
+	};
+}
+
+#endif /* __BOUNDEDQUEUE_H__ */
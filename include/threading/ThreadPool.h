@@ -0,0 +1,42 @@
+#ifndef __THREADPOOL_H__
+#define __THREADPOOL_H__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cut
+{
+	class ThreadPool
+	{
+	public:
+		// A thread count of 0 uses one thread per hardware thread
+		ThreadPool(int threadCount = 0);
+		~ThreadPool();
+
+		void submit(const std::function<void()>& task);
+
+		// Splits [0, count) into batches and runs body(begin, end) on each. The calling thread
+		// takes batches too, so this is safe to call from inside a task.
+		void parallelFor(int count, const std::function<void(int begin, int end)>& body);
+
+		int getThreadCount() const;
+
+		// Shared pool used when an API is given a null pool
+		static ThreadPool* getDefault();
+
+	private:
+		void workerMain();
+
+		std::vector<std::thread> threads;
+		std::deque<std::function<void()> > tasks;
+		std::mutex mutex;
+		std::condition_variable taskAvailable;
+		bool stopping;
+	};
+}
+
+#endif /* __THREADPOOL_H__ */
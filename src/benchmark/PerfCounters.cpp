@@ -0,0 +1,182 @@
+#include "benchmark/PerfCounters.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace cut
+{
+	namespace
+	{
+		const char* counterNames[COUNTER_COUNT] = { "cycles", "instructions", "L1D misses", "LLC misses", "branch misses" };
+
+#ifdef __linux__
+		void getEvent(PerfCounter counter, unsigned int* type, unsigned long long* config)
+		{
+			switch (counter)
+			{
+			case COUNTER_CYCLES:
+				*type = PERF_TYPE_HARDWARE;
+				*config = PERF_COUNT_HW_CPU_CYCLES;
+				break;
+			case COUNTER_INSTRUCTIONS:
+				*type = PERF_TYPE_HARDWARE;
+				*config = PERF_COUNT_HW_INSTRUCTIONS;
+				break;
+			case COUNTER_L1D_MISSES:
+				*type = PERF_TYPE_HW_CACHE;
+				*config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+				break;
+			case COUNTER_LLC_MISSES:
+				*type = PERF_TYPE_HARDWARE;
+				*config = PERF_COUNT_HW_CACHE_MISSES;
+				break;
+			default:
+				*type = PERF_TYPE_HARDWARE;
+				*config = PERF_COUNT_HW_BRANCH_MISSES;
+				break;
+			}
+		}
+
+		// Value, time enabled and time running
+		bool readCounter(int file, long long* values)
+		{
+			return read(file, values, sizeof(long long) * 3) == (ssize_t)(sizeof(long long) * 3);
+		}
+#endif
+	}
+
+	PerfCounters::PerfCounters()
+	{
+		for (int i = 0; i < COUNTER_COUNT; ++i)
+			files[i] = -1;
+
+		error[0] = '\0';
+		reset();
+	}
+
+	PerfCounters::~PerfCounters()
+	{
+		close();
+	}
+
+	int PerfCounters::open()
+	{
+		close();
+
+#ifdef __linux__
+		int openCount = 0;
+
+		for (int i = 0; i < COUNTER_COUNT; ++i)
+		{
+			perf_event_attr attributes;
+			memset(&attributes, 0, sizeof(attributes));
+
+			attributes.size = sizeof(attributes);
+			getEvent((PerfCounter)i, &attributes.type, &attributes.config);
+			attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+			// User space only, which is all perf_event_paranoid allows by default
+			attributes.exclude_kernel = 1;
+			attributes.exclude_hv = 1;
+
+			files[i] = (int)syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+
+			if (files[i] >= 0)
+				openCount++;
+			else if (error[0] == '\0')
+				snprintf(error, sizeof(error), "%s: %s", counterNames[i], strerror(errno));
+		}
+
+		if (openCount > 0)
+			error[0] = '\0';
+
+		return openCount;
+#else
+		strcpy(error, "perf_event_open is only on Linux");
+		return 0;
+#endif
+	}
+
+	void PerfCounters::close()
+	{
+#ifdef __linux__
+		for (int i = 0; i < COUNTER_COUNT; ++i)
+			if (files[i] >= 0)
+				::close(files[i]);
+#endif
+
+		for (int i = 0; i < COUNTER_COUNT; ++i)
+			files[i] = -1;
+
+		error[0] = '\0';
+	}
+
+	bool PerfCounters::isAvailable(PerfCounter counter) const
+	{
+		return files[counter] >= 0;
+	}
+
+	const char* PerfCounters::getError() const
+	{
+		return error;
+	}
+
+	void PerfCounters::start()
+	{
+#ifdef __linux__
+		for (int i = 0; i < COUNTER_COUNT; ++i)
+			if (files[i] >= 0 && !readCounter(files[i], startValues[i]))
+				startValues[i][0] = -1;
+#endif
+	}
+
+	void PerfCounters::stop()
+	{
+#ifdef __linux__
+		for (int i = 0; i < COUNTER_COUNT; ++i)
+		{
+			long long values[3];
+
+			if (files[i] < 0 || startValues[i][0] < 0 || !readCounter(files[i], values))
+				continue;
+
+			double count = (double)(values[0] - startValues[i][0]);
+			long long enabled = values[1] - startValues[i][1];
+			long long running = values[2] - startValues[i][2];
+
+			// Estimate the whole count from the part of the time it was counting
+			if (running > 0 && running < enabled)
+				count *= (double)enabled / (double)running;
+
+			totals[i] += count;
+		}
+#endif
+	}
+
+	void PerfCounters::reset()
+	{
+		for (int i = 0; i < COUNTER_COUNT; ++i)
+		{
+			totals[i] = 0;
+			startValues[i][0] = -1;
+		}
+	}
+
+	long long PerfCounters::get(PerfCounter counter) const
+	{
+		return files[counter] >= 0 ? (long long)(totals[counter] + 0.5) : -1;
+	}
+
+	const char* PerfCounters::getName(PerfCounter counter)
+	{
+		return counterNames[counter];
+	}
+}
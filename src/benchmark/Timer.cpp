@@ -0,0 +1,30 @@
+#include "benchmark/Timer.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace cut
+{
+	double getTime()
+	{
+#ifdef _WIN32
+		static LARGE_INTEGER timerFreq = { 0 };
+
+		if (timerFreq.QuadPart == 0)
+			QueryPerformanceFrequency(&timerFreq);
+
+		LARGE_INTEGER current;
+		QueryPerformanceCounter(&current);
+
+		return (double)current.QuadPart / (double)timerFreq.QuadPart;
+#else
+		timespec current;
+		clock_gettime(CLOCK_MONOTONIC, &current);
+
+		return current.tv_sec + current.tv_nsec * 1e-9;
+#endif
+	}
+}
@@ -0,0 +1,343 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include "benchmark/PerfCounters.h"
+#include "benchmark/Timer.h"
+#include "maths/Vector.h"
+#include "memory/MemoryResource.h"
+#include "meshes/Mesh.h"
+#include "meshes/VertexCacheOptimiser.h"
+
+using namespace cut;
+
+enum Corpus
+{
+	CORPUS_ICOSPHERE,
+	CORPUS_GRID,
+	CORPUS_TERRAIN,
+	CORPUS_SOUP,
+	CORPUS_COUNT
+};
+
+const char* corpusNames[CORPUS_COUNT] = { "icosphere", "grid", "terrain", "soup" };
+
+// Triangle counts from L1 resident up to well past the last level cache
+const int sizes[] = { 1000, 10000, 100000, 1000000, 10000000, 50000000 };
+const int sizeCount = sizeof(sizes) / sizeof(sizes[0]);
+
+const char* tempObjFile = "benchmark_temp.obj";
+
+// Function declarations
+void generate(Mesh* mesh, Corpus corpus, int targetTriangles);
+void writeObj(const Mesh* mesh, const char* filename);
+void benchmarkMesh(const char* name, Mesh* mesh, double generateTime, int repeat, bool measureLoad, PerfCounters* counters);
+void startPhase(PerfCounters* counters);
+void stopPhase(PerfCounters* counters);
+void savePhase(PerfCounters* counters, long long* counts);
+void printCounters(const char* phase, const long long* counts, double triangleCount);
+double median(double* samples, int count);
+
+int main(int argc, char** argv)
+{
+	int maxTriangles = 10000000;
+	int maxLoadTriangles = 1000000;
+	int repeat = 5;
+	const char* onlyCorpus = nullptr;
+	const char* objFile = nullptr;
+	bool useCounters = false;
+	bool spatialOrder = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--max-triangles") == 0 && i + 1 < argc)
+			maxTriangles = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--max-load-triangles") == 0 && i + 1 < argc)
+			maxLoadTriangles = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+			repeat = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--corpus") == 0 && i + 1 < argc)
+			onlyCorpus = argv[++i];
+		else if (strcmp(argv[i], "--obj") == 0 && i + 1 < argc)
+			objFile = argv[++i];
+		else if (strcmp(argv[i], "--counters") == 0)
+			useCounters = true;
+		else if (strcmp(argv[i], "--spatial-order") == 0)
+			spatialOrder = true;
+		else
+		{
+			printf("Usage: %s [--max-triangles n] [--max-load-triangles n] [--repeat n] [--corpus name] [--obj file] [--counters] [--spatial-order]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	// Counters are optional, and the times are still worth having without them
+	PerfCounters perfCounters;
+	PerfCounters* counters = nullptr;
+
+	if (useCounters)
+	{
+		if (perfCounters.open() > 0)
+			counters = &perfCounters;
+		else
+			printf("Hardware counters unavailable (%s), timing only\n", perfCounters.getError());
+	}
+
+	printf("%-10s %10s %10s %12s %12s %12s %12s %12s %12s %12s\n", "corpus", "triangles", "vertices", "generate ms", "cut min ms", "cut med ms", "cut+opt ms", "arena ms", "halves MB", "load ms");
+
+	// Measure a mesh from disk first, if one was given
+	if (objFile != nullptr)
+	{
+		Mesh mesh;
+
+		double start = getTime();
+		mesh.loadObj(objFile);
+		double loadTime = getTime() - start;
+
+		benchmarkMesh(objFile, &mesh, loadTime, repeat, false, counters);
+
+		// And again in spatial order, to see what the file's own order costs
+		if (spatialOrder)
+		{
+			start = getTime();
+			mesh.loadObj(objFile, true);
+			loadTime = getTime() - start;
+
+			benchmarkMesh("(sorted)", &mesh, loadTime, repeat, false, counters);
+		}
+	}
+
+	for (int corpus = 0; corpus < CORPUS_COUNT; ++corpus)
+	{
+		if (onlyCorpus != nullptr && strcmp(onlyCorpus, corpusNames[corpus]) != 0)
+			continue;
+
+		for (int size = 0; size < sizeCount && sizes[size] <= maxTriangles; ++size)
+		{
+			Mesh mesh;
+
+			double start = getTime();
+			generate(&mesh, (Corpus)corpus, sizes[size]);
+			double generateTime = getTime() - start;
+
+			benchmarkMesh(corpusNames[corpus], &mesh, generateTime, repeat, sizes[size] <= maxLoadTriangles, counters);
+		}
+	}
+
+	return 0;
+}
+
+// Pick generator parameters that give roughly the requested number of triangles
+void generate(Mesh* mesh, Corpus corpus, int targetTriangles)
+{
+	int side;
+
+	switch (corpus)
+	{
+	case CORPUS_ICOSPHERE:
+		mesh->createIcosphere(std::max(1, (int)(sqrt(targetTriangles / 20.0) + 0.5)));
+		break;
+	case CORPUS_GRID:
+		side = std::max(1, (int)(sqrt(targetTriangles / 2.0) + 0.5));
+		mesh->createGrid(side, side);
+		break;
+	case CORPUS_TERRAIN:
+		side = std::max(1, (int)(sqrt(targetTriangles / 2.0) + 0.5));
+		mesh->createTerrain(side, side, 0.25f, 1234);
+		break;
+	case CORPUS_SOUP:
+		mesh->createSoup(std::max(1, targetTriangles / 12), 1234);
+		break;
+	default:
+		break;
+	}
+}
+
+void writeObj(const Mesh* mesh, const char* filename)
+{
+	FILE* file = fopen(filename, "w");
+
+	if (file == NULL)
+		return;
+
+	for (int i = 0; i < mesh->vertexCount; ++i)
+		fprintf(file, "v %f %f %f\n", mesh->vertices[i].x, mesh->vertices[i].y, mesh->vertices[i].z);
+
+	for (int i = 0; i < mesh->indexCount; i += 3)
+		fprintf(file, "f %d %d %d\n", mesh->indices[i] + 1, mesh->indices[i+1] + 1, mesh->indices[i+2] + 1);
+
+	fclose(file);
+}
+
+void benchmarkMesh(const char* name, Mesh* mesh, double generateTime, int repeat, bool measureLoad, PerfCounters* counters)
+{
+	Mesh left, right;
+
+	// Oblique plane through the middle of every corpus, so no vertices lie exactly on it
+	Vector3 planePoint = { 0.01f, 0.02f, 0.03f };
+	Vector3 planeNormal = { 1.0f, 2.0f, 3.0f };
+	normalise3(&planeNormal, &planeNormal);
+
+	double* cutTimes = new double[repeat];
+
+	// Counter totals for each phase, kept for printing after the times
+	enum { PHASE_CUT, PHASE_OPTIMISED, PHASE_ARENA, PHASE_LOAD, PHASE_COUNT };
+	long long phaseCounts[PHASE_COUNT][COUNTER_COUNT];
+
+	if (counters != nullptr)
+		counters->reset();
+
+	for (int i = 0; i < repeat; ++i)
+	{
+		double start = getTime();
+		startPhase(counters);
+		mesh->cut(&left, &right, planePoint, planeNormal);
+		stopPhase(counters);
+		cutTimes[i] = getTime() - start;
+	}
+
+	savePhase(counters, phaseCounts[PHASE_CUT]);
+
+	double cutMin = *std::min_element(cutTimes, cutTimes + repeat);
+	double cutMedian = median(cutTimes, repeat);
+
+	// Again with the halves reordered for the vertex cache, reusing one optimiser throughout
+	VertexCacheOptimiser optimiser;
+	CutOptions options;
+	options.optimiser = &optimiser;
+
+	for (int i = 0; i < repeat; ++i)
+	{
+		double start = getTime();
+		startPhase(counters);
+		mesh->cut(&left, &right, planePoint, planeNormal, options);
+		stopPhase(counters);
+		cutTimes[i] = getTime() - start;
+	}
+
+	savePhase(counters, phaseCounts[PHASE_OPTIMISED]);
+
+	double optimisedMedian = median(cutTimes, repeat);
+
+	// Again with the halves in an arena that is rewound before every cut, as once a frame
+	MonotonicResource arena(16 << 20);
+	Mesh arenaLeft(&arena), arenaRight(&arena);
+
+	for (int i = 0; i < repeat; ++i)
+	{
+		arenaLeft.setMemoryResource(&arena);
+		arenaRight.setMemoryResource(&arena);
+		arena.rewind();
+
+		double start = getTime();
+		startPhase(counters);
+		mesh->cut(&arenaLeft, &arenaRight, planePoint, planeNormal);
+		stopPhase(counters);
+		cutTimes[i] = getTime() - start;
+	}
+
+	savePhase(counters, phaseCounts[PHASE_ARENA]);
+
+	double arenaMedian = median(cutTimes, repeat);
+	double halvesMegabytes = arena.getPeakBytes() / (1024.0 * 1024.0);
+
+	delete[] cutTimes;
+
+	// Round trip through an obj file to measure the loader
+	double loadTime = -1.0;
+
+	if (measureLoad)
+	{
+		writeObj(mesh, tempObjFile);
+
+		Mesh loaded;
+
+		double start = getTime();
+		startPhase(counters);
+		loaded.loadObj(tempObjFile);
+		stopPhase(counters);
+		loadTime = getTime() - start;
+
+		savePhase(counters, phaseCounts[PHASE_LOAD]);
+
+		remove(tempObjFile);
+	}
+
+	printf("%-10s %10d %10d %12.3f %12.3f %12.3f %12.3f %12.3f %12.3f ", name, mesh->indexCount / 3, mesh->vertexCount, generateTime * 1000.0, cutMin * 1000.0, cutMedian * 1000.0, optimisedMedian * 1000.0,
+		arenaMedian * 1000.0, halvesMegabytes);
+
+	if (loadTime >= 0.0)
+		printf("%12.3f\n", loadTime * 1000.0);
+	else
+		printf("%12s\n", "-");
+
+	if (counters != nullptr)
+	{
+		int triangleCount = mesh->indexCount / 3;
+
+		printCounters("cut", phaseCounts[PHASE_CUT], (double)triangleCount * repeat);
+		printCounters("cut+opt", phaseCounts[PHASE_OPTIMISED], (double)triangleCount * repeat);
+		printCounters("arena", phaseCounts[PHASE_ARENA], (double)triangleCount * repeat);
+
+		if (loadTime >= 0.0)
+			printCounters("load", phaseCounts[PHASE_LOAD], triangleCount);
+	}
+
+	fflush(stdout);
+}
+
+double median(double* samples, int count)
+{
+	std::sort(samples, samples + count);
+
+	if (count % 2 == 0)
+		return (samples[count / 2 - 1] + samples[count / 2]) * 0.5;
+
+	return samples[count / 2];
+}
+
+// Counting covers only the calls being measured, not the timing or bookkeeping around them
+void startPhase(PerfCounters* counters)
+{
+	if (counters != nullptr)
+		counters->start();
+}
+
+void stopPhase(PerfCounters* counters)
+{
+	if (counters != nullptr)
+		counters->stop();
+}
+
+// Copies out the totals and starts the next phase from zero
+void savePhase(PerfCounters* counters, long long* counts)
+{
+	if (counters == nullptr)
+		return;
+
+	for (int i = 0; i < COUNTER_COUNT; ++i)
+		counts[i] = counters->get((PerfCounter)i);
+
+	counters->reset();
+}
+
+// Counts per triangle, with instructions per cycle to show how well the core is kept busy
+void printCounters(const char* phase, const long long* counts, double triangleCount)
+{
+	printf("  %-8s per triangle:", phase);
+
+	for (int i = 0; i < COUNTER_COUNT; ++i)
+	{
+		if (counts[i] >= 0)
+			printf("  %s %.3f", PerfCounters::getName((PerfCounter)i), counts[i] / triangleCount);
+		else
+			printf("  %s -", PerfCounters::getName((PerfCounter)i));
+	}
+
+	if (counts[COUNTER_CYCLES] > 0 && counts[COUNTER_INSTRUCTIONS] >= 0)
+		printf("  IPC %.2f", (double)counts[COUNTER_INSTRUCTIONS] / counts[COUNTER_CYCLES]);
+
+	printf("\n");
+}
@@ -0,0 +1,400 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "benchmark/Timer.h"
+#include "maths/Vector.h"
+#include "maths/VectorBatch.h"
+#include "maths/Matrix.h"
+#include "maths/MatrixBatch.h"
+
+using namespace cut;
+
+// Inputs and outputs for the throughput runs
+int elementCount = 1 << 20;
+
+Vector3* first;
+Vector3* second;
+Vector3* vectorResults;
+float* floatResults;
+Vector4* vectors4;
+Vector4* vectorResults4;
+Matrix4* matrices;
+Matrix4* matrixResults;
+
+Matrix4 rotation;
+Vector3 planeNormal = { 0.267261f, 0.534522f, 0.801784f };
+Vector3 planePoint = { 0.1f, 0.2f, 0.3f };
+
+// Results are written here so the chains can't be optimised away
+volatile float sink;
+
+// Throughput: one call per element over arrays much larger than the cache
+void dot3Scalar(int count)
+{
+	for (int i = 0; i < count; ++i)
+		floatResults[i] = dot3(&first[i], &second[i]);
+}
+
+void dot3Simd(int count)
+{
+	dot3Batch(first, second, floatResults, count);
+}
+
+void normalise3Scalar(int count)
+{
+	for (int i = 0; i < count; ++i)
+		normalise3(&first[i], &vectorResults[i]);
+}
+
+void normalise3Simd(int count)
+{
+	normalise3Batch(first, vectorResults, count);
+}
+
+void linePlaneScalar(int count)
+{
+	for (int i = 0; i < count; ++i)
+		floatResults[i] = linePlaneCoefficient(&first[i], &second[i], &planeNormal, &planePoint);
+}
+
+void linePlaneSimd(int count)
+{
+	linePlaneCoefficientBatch(first, second, &planeNormal, &planePoint, floatResults, count);
+}
+
+void planeDistanceScalar(int count)
+{
+	// The way Mesh::cut classifies vertices
+	for (int i = 0; i < count; ++i)
+	{
+		Vector3 toPlane;
+		sub3(&first[i], &planePoint, &toPlane);
+		floatResults[i] = dot3(&toPlane, &planeNormal);
+	}
+}
+
+void planeDistanceSimd(int count)
+{
+	planeDistanceBatch(first, &planeNormal, &planePoint, floatResults, count);
+}
+
+void multVector4Scalar(int count)
+{
+	for (int i = 0; i < count; ++i)
+		multVector4(&rotation, &vectors4[i], &vectorResults4[i]);
+}
+
+void multVector4Simd(int count)
+{
+	multVector4Batch(&rotation, vectors4, vectorResults4, count);
+}
+
+void multMatrix4Scalar(int count)
+{
+	for (int i = 0; i < count / 4; ++i)
+		multMatrix4(&rotation, &matrices[i], &matrixResults[i]);
+}
+
+void multMatrix4Batched(int count)
+{
+	for (int i = 0; i < count / 4; ++i)
+		multMatrix4Simd(&rotation, &matrices[i], &matrixResults[i]);
+}
+
+// Latency: chains of calls where each input depends on the previous result.
+// The SIMD versions run four independent chains through one batch of four.
+void dot3ScalarChain(int iterations)
+{
+	Vector3 v = { 1.0f, 2.0f, 3.0f };
+	Vector3 w = { 0.5f, 0.25f, 0.125f };
+
+	for (int i = 0; i < iterations; ++i)
+		v.x = dot3(&v, &w);
+
+	sink = v.x;
+}
+
+void dot3SimdChain(int iterations)
+{
+	Vector3 v[4] = { { 1.0f, 2.0f, 3.0f }, { 2.0f, 3.0f, 4.0f }, { 3.0f, 4.0f, 5.0f }, { 4.0f, 5.0f, 6.0f } };
+	Vector3 w[4] = { { 0.5f, 0.25f, 0.125f }, { 0.5f, 0.25f, 0.125f }, { 0.5f, 0.25f, 0.125f }, { 0.5f, 0.25f, 0.125f } };
+	float d[4];
+
+	for (int i = 0; i < iterations; ++i)
+	{
+		dot3Batch(v, w, d, 4);
+
+		v[0].x = d[0];
+		v[1].x = d[1];
+		v[2].x = d[2];
+		v[3].x = d[3];
+	}
+
+	sink = v[0].x;
+}
+
+void normalise3ScalarChain(int iterations)
+{
+	Vector3 v = { 1.0f, 2.0f, 3.0f };
+
+	for (int i = 0; i < iterations; ++i)
+		normalise3(&v, &v);
+
+	sink = v.x;
+}
+
+void normalise3SimdChain(int iterations)
+{
+	Vector3 v[4] = { { 1.0f, 2.0f, 3.0f }, { 2.0f, 3.0f, 4.0f }, { 3.0f, 4.0f, 5.0f }, { 4.0f, 5.0f, 6.0f } };
+
+	for (int i = 0; i < iterations; ++i)
+		normalise3Batch(v, v, 4);
+
+	sink = v[0].x;
+}
+
+void linePlaneScalarChain(int iterations)
+{
+	Vector3 point = { 1.0f, 2.0f, 3.0f };
+	Vector3 dir = { -1.0f, -1.0f, -1.0f };
+
+	for (int i = 0; i < iterations; ++i)
+		point.x = linePlaneCoefficient(&point, &dir, &planeNormal, &planePoint);
+
+	sink = point.x;
+}
+
+void linePlaneSimdChain(int iterations)
+{
+	Vector3 points[4] = { { 1.0f, 2.0f, 3.0f }, { 2.0f, 3.0f, 4.0f }, { 3.0f, 4.0f, 5.0f }, { 4.0f, 5.0f, 6.0f } };
+	Vector3 dirs[4] = { { -1.0f, -1.0f, -1.0f }, { -1.0f, -1.0f, -1.0f }, { -1.0f, -1.0f, -1.0f }, { -1.0f, -1.0f, -1.0f } };
+	float t[4];
+
+	for (int i = 0; i < iterations; ++i)
+	{
+		linePlaneCoefficientBatch(points, dirs, &planeNormal, &planePoint, t, 4);
+
+		points[0].x = t[0];
+		points[1].x = t[1];
+		points[2].x = t[2];
+		points[3].x = t[3];
+	}
+
+	sink = points[0].x;
+}
+
+void planeDistanceScalarChain(int iterations)
+{
+	Vector3 point = { 1.0f, 2.0f, 3.0f };
+
+	for (int i = 0; i < iterations; ++i)
+	{
+		Vector3 toPlane;
+		sub3(&point, &planePoint, &toPlane);
+		point.x = dot3(&toPlane, &planeNormal);
+	}
+
+	sink = point.x;
+}
+
+void planeDistanceSimdChain(int iterations)
+{
+	Vector3 points[4] = { { 1.0f, 2.0f, 3.0f }, { 2.0f, 3.0f, 4.0f }, { 3.0f, 4.0f, 5.0f }, { 4.0f, 5.0f, 6.0f } };
+	float d[4];
+
+	for (int i = 0; i < iterations; ++i)
+	{
+		planeDistanceBatch(points, &planeNormal, &planePoint, d, 4);
+
+		points[0].x = d[0];
+		points[1].x = d[1];
+		points[2].x = d[2];
+		points[3].x = d[3];
+	}
+
+	sink = points[0].x;
+}
+
+void multVector4ScalarChain(int iterations)
+{
+	Vector4 v = { 1.0f, 2.0f, 3.0f, 1.0f };
+	Vector4 result;
+
+	for (int i = 0; i < iterations; ++i)
+	{
+		multVector4(&rotation, &v, &result);
+		v = result;
+	}
+
+	sink = v.x;
+}
+
+void multVector4SimdChain(int iterations)
+{
+	Vector4 v[4] = { { 1.0f, 2.0f, 3.0f, 1.0f }, { 2.0f, 3.0f, 4.0f, 1.0f }, { 3.0f, 4.0f, 5.0f, 1.0f }, { 4.0f, 5.0f, 6.0f, 1.0f } };
+
+	for (int i = 0; i < iterations; ++i)
+		multVector4Batch(&rotation, v, v, 4);
+
+	sink = v[0].x;
+}
+
+void multMatrix4ScalarChain(int iterations)
+{
+	Matrix4 m = rotation;
+	Matrix4 result;
+
+	for (int i = 0; i < iterations; ++i)
+	{
+		multMatrix4(&rotation, &m, &result);
+		m = result;
+	}
+
+	sink = m.data[0];
+}
+
+void multMatrix4SimdChain(int iterations)
+{
+	Matrix4 m = rotation;
+
+	for (int i = 0; i < iterations; ++i)
+		multMatrix4Simd(&rotation, &m, &m);
+
+	sink = m.data[0];
+}
+
+typedef void (*BenchmarkFunction)(int);
+
+struct Kernel
+{
+	const char* name;
+	BenchmarkFunction scalar;
+	BenchmarkFunction simd;
+	BenchmarkFunction scalarChain;
+	BenchmarkFunction simdChain;
+	int chainWidth;
+};
+
+Kernel kernels[] =
+{
+	{ "dot3", dot3Scalar, dot3Simd, dot3ScalarChain, dot3SimdChain, 4 },
+	{ "normalise3", normalise3Scalar, normalise3Simd, normalise3ScalarChain, normalise3SimdChain, 4 },
+	{ "linePlaneCoefficient", linePlaneScalar, linePlaneSimd, linePlaneScalarChain, linePlaneSimdChain, 4 },
+	{ "planeDistance", planeDistanceScalar, planeDistanceSimd, planeDistanceScalarChain, planeDistanceSimdChain, 4 },
+	{ "multVector4", multVector4Scalar, multVector4Simd, multVector4ScalarChain, multVector4SimdChain, 4 },
+	{ "multMatrix4", multMatrix4Scalar, multMatrix4Batched, multMatrix4ScalarChain, multMatrix4SimdChain, 1 }
+};
+
+const int kernelCount = sizeof(kernels) / sizeof(kernels[0]);
+
+// Best time of several runs, in nanoseconds per unit of work
+double measure(BenchmarkFunction function, int argument, int units, int repeat)
+{
+	double best = 1e30;
+
+	for (int i = 0; i < repeat; ++i)
+	{
+		double start = getTime();
+		function(argument);
+		best = std::min(best, getTime() - start);
+	}
+
+	return best * 1e9 / units;
+}
+
+int main(int argc, char** argv)
+{
+	int iterations = 1 << 22;
+	int repeat = 5;
+	const char* onlyKernel = nullptr;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+			elementCount = std::max(4, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+			iterations = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+			repeat = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--kernel") == 0 && i + 1 < argc)
+			onlyKernel = argv[++i];
+		else
+		{
+			printf("Usage: %s [--count n] [--iterations n] [--repeat n] [--kernel name]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	// Allocate and fill inputs
+	first = new Vector3[elementCount];
+	second = new Vector3[elementCount];
+	vectorResults = new Vector3[elementCount];
+	floatResults = new float[elementCount];
+	vectors4 = new Vector4[elementCount];
+	vectorResults4 = new Vector4[elementCount];
+	matrices = new Matrix4[elementCount / 4];
+	matrixResults = new Matrix4[elementCount / 4];
+
+	rotationY(&rotation, 0.1);
+
+	unsigned int state = 12345;
+
+	for (int i = 0; i < elementCount; ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			state = state * 1664525 + 1013904223;
+			first[i].data[j] = (state >> 8) * (2.0f / 16777216.0f) - 1.0f;
+
+			state = state * 1664525 + 1013904223;
+			second[i].data[j] = (state >> 8) * (2.0f / 16777216.0f) - 1.0f;
+
+			vectors4[i].data[j] = first[i].data[j];
+		}
+
+		vectors4[i].w = 1.0f;
+	}
+
+	for (int i = 0; i < elementCount / 4; ++i)
+		matrices[i] = rotation;
+
+	printf("%d elements, %d chain iterations\n\n", elementCount, iterations);
+	printf("%-22s %14s %14s %8s %14s %14s %8s\n", "", "scalar ns/op", "simd ns/op", "speedup", "scalar lat ns", "simd lat ns", "speedup");
+
+	for (int i = 0; i < kernelCount; ++i)
+	{
+		const Kernel* kernel = &kernels[i];
+
+		if (onlyKernel != nullptr && strcmp(onlyKernel, kernel->name) != 0)
+			continue;
+
+		// Matrix products are measured per matrix rather than per element
+		int units = kernel->chainWidth == 1 ? elementCount / 4 : elementCount;
+
+		double scalar = measure(kernel->scalar, elementCount, units, repeat);
+		double simd = measure(kernel->simd, elementCount, units, repeat);
+
+		// Latency is per call, and each SIMD call advances chainWidth chains at once
+		double scalarLatency = measure(kernel->scalarChain, iterations, iterations, repeat);
+		double simdLatency = measure(kernel->simdChain, iterations, iterations, repeat);
+
+		printf("%-22s %14.3f %14.3f %7.2fx %14.3f %14.3f %7.2fx\n", kernel->name,
+			scalar, simd, scalar / simd,
+			scalarLatency, simdLatency, scalarLatency * kernel->chainWidth / simdLatency);
+
+		fflush(stdout);
+	}
+
+	delete[] first;
+	delete[] second;
+	delete[] vectorResults;
+	delete[] floatResults;
+	delete[] vectors4;
+	delete[] vectorResults4;
+	delete[] matrices;
+	delete[] matrixResults;
+
+	return 0;
+}
@@ -0,0 +1,41 @@
+#include "maths/MatrixBatch.h"
+#include "maths/Matrix.h"
+#include "maths/Simd.h"
+
+namespace cut
+{
+	void multVector4Batch(const Matrix4* matrix, const Vector4* vectors, Vector4* result, int count)
+	{
+#ifdef CUT_SSE
+		// Matrices are column major, so the result is the sum of the columns scaled by each component
+		__m128 column0 = _mm_loadu_ps(&matrix->data[0]);
+		__m128 column1 = _mm_loadu_ps(&matrix->data[4]);
+		__m128 column2 = _mm_loadu_ps(&matrix->data[8]);
+		__m128 column3 = _mm_loadu_ps(&matrix->data[12]);
+
+		for (int i = 0; i < count; ++i)
+		{
+			__m128 v = _mm_loadu_ps(vectors[i].data);
+
+			__m128 sum = _mm_mul_ps(column0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+			sum = _mm_add_ps(sum, _mm_mul_ps(column1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+			sum = _mm_add_ps(sum, _mm_mul_ps(column2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+			sum = _mm_add_ps(sum, _mm_mul_ps(column3, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+
+			_mm_storeu_ps(result[i].data, sum);
+		}
+#else
+		for (int i = 0; i < count; ++i)
+			multMatrix((float*)matrix->data, 4, 4, (float*)vectors[i].data, 1, 4, result[i].data);
+#endif
+	}
+
+	void multMatrix4Simd(const Matrix4* first, const Matrix4* second, Matrix4* result)
+	{
+		// Each column of the result is the first matrix applied to a column of the second
+		Matrix4 temp;
+		multVector4Batch(first, &second->a, &temp.a, 4);
+
+		*result = temp;
+	}
+}
@@ -0,0 +1,147 @@
+#include "maths/VectorBatch.h"
+#include "maths/Vector.h"
+#include "maths/Simd.h"
+
+#include <math.h>
+
+namespace cut
+{
+#ifdef CUT_SSE
+	namespace
+	{
+		// Load four packed Vector3s and transpose them into x, y and z registers
+		inline void load4(const Vector3* v, __m128* x, __m128* y, __m128* z)
+		{
+			const float* data = v->data;
+
+			__m128 a = _mm_loadu_ps(data);		// x0 y0 z0 x1
+			__m128 b = _mm_loadu_ps(data + 4);	// y1 z1 x2 y2
+			__m128 c = _mm_loadu_ps(data + 8);	// z2 x3 y3 z3
+
+			__m128 bc = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 0, 2, 0));
+			*x = _mm_shuffle_ps(a, bc, _MM_SHUFFLE(3, 1, 3, 0));
+
+			__m128 ab = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 0, 1));
+			bc = _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 2, 3, 0));
+			*y = _mm_shuffle_ps(ab, bc, _MM_SHUFFLE(2, 1, 2, 0));
+
+			ab = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 1, 0, 2));
+			*z = _mm_shuffle_ps(ab, c, _MM_SHUFFLE(3, 0, 2, 0));
+		}
+
+		// Inverse of load4
+		inline void store4(Vector3* v, __m128 x, __m128 y, __m128 z)
+		{
+			float* data = v->data;
+
+			__m128 xyLow = _mm_unpacklo_ps(x, y);
+			__m128 xyHigh = _mm_unpackhi_ps(x, y);
+
+			__m128 zx = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+			_mm_storeu_ps(data, _mm_shuffle_ps(xyLow, zx, _MM_SHUFFLE(2, 0, 1, 0)));
+
+			__m128 yz = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+			_mm_storeu_ps(data + 4, _mm_shuffle_ps(yz, xyHigh, _MM_SHUFFLE(1, 0, 2, 0)));
+
+			__m128 zx2 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));
+			__m128 yz2 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));
+			_mm_storeu_ps(data + 8, _mm_shuffle_ps(zx2, yz2, _MM_SHUFFLE(2, 0, 2, 0)));
+		}
+
+		inline __m128 dot4x3(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+		{
+			return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+		}
+	}
+#endif
+
+	void dot3Batch(const Vector3* first, const Vector3* second, float* result, int count)
+	{
+		int i = 0;
+
+#ifdef CUT_SSE
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 ax, ay, az, bx, by, bz;
+			load4(&first[i], &ax, &ay, &az);
+			load4(&second[i], &bx, &by, &bz);
+
+			_mm_storeu_ps(&result[i], dot4x3(ax, ay, az, bx, by, bz));
+		}
+#endif
+
+		for (; i < count; ++i)
+			result[i] = dot3(&first[i], &second[i]);
+	}
+
+	void normalise3Batch(const Vector3* first, Vector3* result, int count)
+	{
+		int i = 0;
+
+#ifdef CUT_SSE
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x, y, z;
+			load4(&first[i], &x, &y, &z);
+
+			__m128 length = _mm_sqrt_ps(dot4x3(x, y, z, x, y, z));
+
+			store4(&result[i], _mm_div_ps(x, length), _mm_div_ps(y, length), _mm_div_ps(z, length));
+		}
+#endif
+
+		for (; i < count; ++i)
+			normalise3(&first[i], &result[i]);
+	}
+
+	void linePlaneCoefficientBatch(const Vector3* linePoints, const Vector3* lineDirs, const Vector3* planeNormal, const Vector3* planePoint, float* result, int count)
+	{
+		int i = 0;
+
+#ifdef CUT_SSE
+		__m128 nx = _mm_set1_ps(planeNormal->x);
+		__m128 ny = _mm_set1_ps(planeNormal->y);
+		__m128 nz = _mm_set1_ps(planeNormal->z);
+		__m128 planeDot = _mm_set1_ps(dot3(planeNormal, planePoint));
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 px, py, pz, dx, dy, dz;
+			load4(&linePoints[i], &px, &py, &pz);
+			load4(&lineDirs[i], &dx, &dy, &dz);
+
+			__m128 numerator = _mm_sub_ps(planeDot, dot4x3(nx, ny, nz, px, py, pz));
+			__m128 denominator = dot4x3(nx, ny, nz, dx, dy, dz);
+
+			_mm_storeu_ps(&result[i], _mm_div_ps(numerator, denominator));
+		}
+#endif
+
+		for (; i < count; ++i)
+			result[i] = linePlaneCoefficient(&linePoints[i], &lineDirs[i], planeNormal, planePoint);
+	}
+
+	void planeDistanceBatch(const Vector3* points, const Vector3* planeNormal, const Vector3* planePoint, float* result, int count)
+	{
+		float planeDot = dot3(planeNormal, planePoint);
+		int i = 0;
+
+#ifdef CUT_SSE
+		__m128 nx = _mm_set1_ps(planeNormal->x);
+		__m128 ny = _mm_set1_ps(planeNormal->y);
+		__m128 nz = _mm_set1_ps(planeNormal->z);
+		__m128 planeDot4 = _mm_set1_ps(planeDot);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x, y, z;
+			load4(&points[i], &x, &y, &z);
+
+			_mm_storeu_ps(&result[i], _mm_sub_ps(dot4x3(nx, ny, nz, x, y, z), planeDot4));
+		}
+#endif
+
+		for (; i < count; ++i)
+			result[i] = dot3(planeNormal, &points[i]) - planeDot;
+	}
+}
@@ -0,0 +1,191 @@
+#include "memory/MemoryResource.h"
+
+#include <stdint.h>
+#include <mutex>
+#include <new>
+
+namespace cut
+{
+	namespace
+	{
+		std::once_flag defaultResourceFlag;
+		MemoryResource* defaultResource = nullptr;
+
+		char* alignPointer(char* pointer, size_t alignment)
+		{
+			uintptr_t address = reinterpret_cast<uintptr_t>(pointer);
+
+			return pointer + ((alignment - address % alignment) % alignment);
+		}
+	}
+
+	MemoryResource::MemoryResource()
+		: liveBytes(0), peakBytes(0), allocationCount(0), deallocationCount(0)
+	{
+
+	}
+
+	MemoryResource::~MemoryResource()
+	{
+
+	}
+
+	void* MemoryResource::allocate(size_t bytes, size_t alignment)
+	{
+		void* pointer = doAllocate(bytes, alignment);
+
+		long long live = liveBytes.fetch_add((long long)bytes) + (long long)bytes;
+		long long peak = peakBytes.load();
+
+		while (live > peak && !peakBytes.compare_exchange_weak(peak, live))
+		{
+		}
+
+		allocationCount.fetch_add(1);
+
+		return pointer;
+	}
+
+	void MemoryResource::deallocate(void* pointer, size_t bytes, size_t alignment)
+	{
+		if (doDeallocate(pointer, bytes, alignment))
+			liveBytes.fetch_sub((long long)bytes);
+
+		deallocationCount.fetch_add(1);
+	}
+
+	long long MemoryResource::getLiveBytes() const
+	{
+		return liveBytes.load();
+	}
+
+	long long MemoryResource::getPeakBytes() const
+	{
+		return peakBytes.load();
+	}
+
+	long long MemoryResource::getAllocationCount() const
+	{
+		return allocationCount.load();
+	}
+
+	long long MemoryResource::getDeallocationCount() const
+	{
+		return deallocationCount.load();
+	}
+
+	void MemoryResource::resetPeak()
+	{
+		peakBytes.store(liveBytes.load());
+	}
+
+	MemoryResource* MemoryResource::getDefault()
+	{
+		std::call_once(defaultResourceFlag, []() { defaultResource = new NewDeleteResource(); });
+
+		return defaultResource;
+	}
+
+	void MemoryResource::releaseLiveBytes(long long bytes)
+	{
+		liveBytes.fetch_sub(bytes);
+	}
+
+	void* NewDeleteResource::doAllocate(size_t bytes, size_t alignment)
+	{
+		// Room to align, and to keep what operator new returned just in front of the result
+		char* memory = static_cast<char*>(::operator new(bytes + alignment + sizeof(void*)));
+		char* aligned = alignPointer(memory + sizeof(void*), alignment);
+
+		reinterpret_cast<void**>(aligned)[-1] = memory;
+
+		return aligned;
+	}
+
+	bool NewDeleteResource::doDeallocate(void* pointer, size_t, size_t)
+	{
+		::operator delete(static_cast<void**>(pointer)[-1]);
+
+		return true;
+	}
+
+	MonotonicResource::MonotonicResource(size_t blockSize, MemoryResource* upstream)
+		: upstream(upstream != nullptr ? upstream : MemoryResource::getDefault()), blockSize(blockSize), firstBlock(nullptr), currentBlock(nullptr), current(nullptr), end(nullptr)
+	{
+
+	}
+
+	MonotonicResource::~MonotonicResource()
+	{
+		release();
+	}
+
+	void MonotonicResource::rewind()
+	{
+		currentBlock = nullptr;
+		current = nullptr;
+		end = nullptr;
+
+		releaseLiveBytes(getLiveBytes());
+	}
+
+	void MonotonicResource::release()
+	{
+		while (firstBlock != nullptr)
+		{
+			Block* next = firstBlock->next;
+
+			upstream->deallocate(firstBlock, firstBlock->size);
+			firstBlock = next;
+		}
+
+		rewind();
+	}
+
+	void* MonotonicResource::doAllocate(size_t bytes, size_t alignment)
+	{
+		char* aligned = current != nullptr ? alignPointer(current, alignment) : nullptr;
+
+		while (aligned == nullptr || aligned + bytes > end)
+		{
+			Block* next = currentBlock != nullptr ? currentBlock->next : firstBlock;
+			size_t size = sizeof(Block) + alignment + bytes;
+
+			// Move on to the next block kept from before a rewind, or put a new one in front of it
+			// if there isn't one or it's too small. Anything too big for a block gets its own.
+			if (next == nullptr || next->size < size)
+			{
+				if (size < blockSize)
+					size = blockSize;
+
+				Block* block = static_cast<Block*>(upstream->allocate(size));
+
+				block->next = next;
+				block->size = size;
+
+				if (currentBlock != nullptr)
+					currentBlock->next = block;
+				else
+					firstBlock = block;
+
+				next = block;
+			}
+
+			currentBlock = next;
+			current = reinterpret_cast<char*>(next + 1);
+			end = reinterpret_cast<char*>(next) + next->size;
+
+			aligned = alignPointer(current, alignment);
+		}
+
+		current = aligned + bytes;
+
+		return aligned;
+	}
+
+	// Blocks are only given back all at once, by rewind and release
+	bool MonotonicResource::doDeallocate(void*, size_t, size_t)
+	{
+		return false;
+	}
+}
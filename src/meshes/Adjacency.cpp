@@ -0,0 +1,86 @@
+#include "meshes/Mesh.h"
+
+#include "memory/MemoryResource.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace cut
+{
+	void Mesh::buildAdjacency()
+	{
+		clearAdjacency();
+
+		opposites = allocateArray<int>(resource, indexCount);
+
+		int cornerCount = indexCount - indexCount % 3;
+
+		for (int i = 0; i < indexCount; ++i)
+			opposites[i] = -1;
+
+		// Group the half edges by their lower vertex with a counting sort
+		int* starts = new int[vertexCount + 1];
+		int* order = new int[cornerCount > 0 ? cornerCount : 1];
+
+		memset(starts, 0, (vertexCount + 1) * sizeof(int));
+
+		for (int i = 0; i < cornerCount; ++i)
+			++starts[std::min(indices[i], indices[nextCorner(i)]) + 1];
+
+		for (int i = 0; i < vertexCount; ++i)
+			starts[i + 1] += starts[i];
+
+		int* cursors = new int[vertexCount];
+		memcpy(cursors, starts, vertexCount * sizeof(int));
+
+		for (int i = 0; i < cornerCount; ++i)
+			order[cursors[std::min(indices[i], indices[nextCorner(i)])]++] = i;
+
+		delete[] cursors;
+
+		// Within a group, half edges on the same edge end up next to each other once sorted
+		// by their upper vertex. Pair the first two running in opposite directions.
+		for (int i = 0; i < vertexCount; ++i)
+		{
+			int* group = &order[starts[i]];
+			int groupSize = starts[i + 1] - starts[i];
+
+			std::sort(group, group + groupSize, [&](int first, int second)
+			{
+				int firstUpper = std::max(indices[first], indices[nextCorner(first)]);
+				int secondUpper = std::max(indices[second], indices[nextCorner(second)]);
+
+				return firstUpper < secondUpper || (firstUpper == secondUpper && first < second);
+			});
+
+			for (int j = 0; j < groupSize; ++j)
+			{
+				int corner = group[j];
+				int upper = std::max(indices[corner], indices[nextCorner(corner)]);
+
+				for (int k = j + 1; k < groupSize && opposites[corner] == -1; ++k)
+				{
+					int other = group[k];
+
+					if (std::max(indices[other], indices[nextCorner(other)]) != upper)
+						break;
+
+					if (opposites[other] == -1 && indices[other] == indices[nextCorner(corner)] && indices[nextCorner(other)] == indices[corner])
+					{
+						opposites[corner] = other;
+						opposites[other] = corner;
+					}
+				}
+			}
+		}
+
+		delete[] starts;
+		delete[] order;
+	}
+
+	void Mesh::clearAdjacency()
+	{
+		freeArray(resource, opposites);
+		opposites = nullptr;
+	}
+}
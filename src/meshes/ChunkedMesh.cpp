@@ -0,0 +1,495 @@
+#include "meshes/ChunkedMesh.h"
+
+#include "maths/VectorBatch.h"
+#include "memory/MemoryResource.h"
+#include "meshes/TriangleSplit.h"
+#include "threading/ThreadPool.h"
+
+#include <limits.h>
+#include <string.h>
+#include <unordered_map>
+
+namespace cut
+{
+	namespace
+	{
+		void allocateChunk(MeshChunk* chunk, int vertexCount, int indexCount, bool hasNormals)
+		{
+			chunk->vertices = new Vector3[vertexCount > 0 ? vertexCount : 1];
+			chunk->vertexNormals = hasNormals ? new Vector3[vertexCount > 0 ? vertexCount : 1] : nullptr;
+			chunk->vertexCount = vertexCount;
+
+			if (vertexCount <= ChunkedMesh::CHUNK_VERTICES)
+			{
+				chunk->shortIndices = new unsigned short[indexCount > 0 ? indexCount : 1];
+				chunk->longIndices = nullptr;
+			}
+			else
+			{
+				chunk->shortIndices = nullptr;
+				chunk->longIndices = new unsigned int[indexCount > 0 ? indexCount : 1];
+			}
+
+			chunk->indexCount = indexCount;
+		}
+
+		void setIndex(MeshChunk* chunk, int i, int vertex)
+		{
+			if (chunk->shortIndices != nullptr)
+				chunk->shortIndices[i] = (unsigned short)vertex;
+			else
+				chunk->longIndices[i] = (unsigned int)vertex;
+		}
+
+		// Orders edge ends by position rather than index, as a vertex copied into several chunks
+		// has a different index in each but the same position
+		bool isBefore(const Vector3* a, const Vector3* b)
+		{
+			if (a->x != b->x)
+				return a->x < b->x;
+
+			if (a->y != b->y)
+				return a->y < b->y;
+
+			return a->z < b->z;
+		}
+
+		// Copies the vertices the faces use into a chunk of their own, in order of first use
+		void writeHalf(MeshChunk* half, const Vector3* vertices, const Vector3* normals, int vertexCount, const int* indices, int indexCount)
+		{
+			int* remap = new int[vertexCount > 0 ? vertexCount : 1];
+			int usedCount = 0;
+
+			for (int i = 0; i < vertexCount; ++i)
+				remap[i] = -1;
+
+			for (int i = 0; i < indexCount; ++i)
+				if (remap[indices[i]] == -1)
+					remap[indices[i]] = usedCount++;
+
+			allocateChunk(half, usedCount, indexCount, normals != nullptr);
+
+			for (int i = 0; i < vertexCount; ++i)
+			{
+				if (remap[i] == -1)
+					continue;
+
+				half->vertices[remap[i]] = vertices[i];
+
+				if (normals != nullptr)
+					half->vertexNormals[remap[i]] = normals[i];
+			}
+
+			for (int i = 0; i < indexCount; ++i)
+				setIndex(half, i, remap[indices[i]]);
+
+			delete[] remap;
+		}
+
+		void cutChunk(const MeshChunk* chunk, MeshChunk* left, MeshChunk* right, const Vector3* planePoint, const Vector3* planeNormal, float epsilon)
+		{
+			int vertexCount = chunk->vertexCount;
+			int faceCount = chunk->indexCount / 3;
+
+			float* distances = new float[vertexCount > 0 ? vertexCount : 1];
+			PlaneSide* sides = new PlaneSide[vertexCount > 0 ? vertexCount : 1];
+
+			planeDistanceBatch(chunk->vertices, planeNormal, planePoint, distances, vertexCount);
+
+			for (int i = 0; i < vertexCount; ++i)
+				sides[i] = classifyDistance(distances[i], epsilon);
+
+			// Count the faces on each side first, so the scratch space is only as big as the cut needs
+			int sideFaceCounts[2] = { 0, 0 };
+			int crossingFaceCount = 0;
+
+			for (int i = 0; i < faceCount; ++i)
+			{
+				PlaneSide a = sides[chunk->getIndex(i * 3)];
+				PlaneSide b = sides[chunk->getIndex(i * 3 + 1)];
+				PlaneSide c = sides[chunk->getIndex(i * 3 + 2)];
+
+				bool hasLeft = a == SIDE_LEFT || b == SIDE_LEFT || c == SIDE_LEFT;
+				bool hasRight = a == SIDE_RIGHT || b == SIDE_RIGHT || c == SIDE_RIGHT;
+
+				if (hasLeft && hasRight)
+					crossingFaceCount++;
+				else
+					sideFaceCounts[hasRight ? 1 : 0]++;
+			}
+
+			// At most two intersections a crossing face, and each splits into at most two on a side.
+			// Faces lying in the plane are counted on the left, so the right gets room for them too.
+			int newVertexCount = vertexCount;
+			int newVertexMax = vertexCount + crossingFaceCount * 2;
+			int halfIndexMaxes[2] = { (sideFaceCounts[0] + crossingFaceCount * 2) * 3, (sideFaceCounts[0] + sideFaceCounts[1] + crossingFaceCount * 2) * 3 };
+
+			Vector3* newVertices = new Vector3[newVertexMax > 0 ? newVertexMax : 1];
+			Vector3* newNormals = chunk->vertexNormals != nullptr ? new Vector3[newVertexMax > 0 ? newVertexMax : 1] : nullptr;
+
+			memcpy(newVertices, chunk->vertices, vertexCount * sizeof(Vector3));
+
+			if (newNormals != nullptr)
+				memcpy(newNormals, chunk->vertexNormals, vertexCount * sizeof(Vector3));
+
+			MeshChunk* halves[2] = { left, right };
+			int* halfIndices[2] = { nullptr, nullptr };
+			int halfIndexCounts[2] = { 0, 0 };
+
+			for (int i = 0; i < 2; ++i)
+				if (halves[i] != nullptr)
+					halfIndices[i] = new int[halfIndexMaxes[i] > 0 ? halfIndexMaxes[i] : 1];
+
+			std::unordered_map<unsigned long long, int> edgeVertices;
+
+			for (int i = 0; i < faceCount; ++i)
+			{
+				int face[3] = { chunk->getIndex(i * 3), chunk->getIndex(i * 3 + 1), chunk->getIndex(i * 3 + 2) };
+
+				PlaneSide faceSides[3] = { sides[face[0]], sides[face[1]], sides[face[2]] };
+
+				TriangleSplit split;
+				splitTriangle(faceSides, &split);
+
+				// Faces lying in the plane go to the half they face into
+				if (split.sides[0] == SIDE_ON)
+				{
+					Vector3 edge1, edge2, faceNormal;
+
+					sub3(&chunk->vertices[face[2]], &chunk->vertices[face[0]], &edge1);
+					sub3(&chunk->vertices[face[1]], &chunk->vertices[face[0]], &edge2);
+					cross3(&edge1, &edge2, &faceNormal);
+
+					split.sides[0] = dot3(&faceNormal, planeNormal) > 0 ? SIDE_RIGHT : SIDE_LEFT;
+				}
+
+				int splitVertices[SPLIT_EDGE + 3] = { face[0], face[1], face[2], -1, -1, -1 };
+
+				for (int j = 0; j < split.triangleCount; ++j)
+				{
+					int half = split.sides[j] == SIDE_LEFT ? 0 : 1;
+
+					if (halves[half] == nullptr)
+						continue;
+
+					for (int k = 0; k < 3; ++k)
+					{
+						int corner = split.corners[j][k];
+
+						if (splitVertices[corner] != -1)
+							continue;
+
+						int ia = face[corner - SPLIT_EDGE];
+						int ib = face[(corner - SPLIT_EDGE + 1) % 3];
+
+						if (ia > ib)
+						{
+							int temp = ia;
+							ia = ib;
+							ib = temp;
+						}
+
+						unsigned long long key = ((unsigned long long)ia << 32) | (unsigned int)ib;
+
+						std::unordered_map<unsigned long long, int>::iterator existing = edgeVertices.find(key);
+
+						if (existing != edgeVertices.end())
+						{
+							splitVertices[corner] = existing->second;
+							continue;
+						}
+
+						int from = isBefore(&chunk->vertices[ib], &chunk->vertices[ia]) ? ib : ia;
+						int to = from == ia ? ib : ia;
+
+						float t = distances[from] / (distances[from] - distances[to]);
+						int intersectIndex = newVertexCount++;
+
+						lerp3(&chunk->vertices[from], &chunk->vertices[to], t, &newVertices[intersectIndex]);
+
+						if (newNormals != nullptr)
+							lerp3(&chunk->vertexNormals[from], &chunk->vertexNormals[to], t, &newNormals[intersectIndex]);
+
+						edgeVertices[key] = intersectIndex;
+						splitVertices[corner] = intersectIndex;
+					}
+
+					int* targetIndices = halfIndices[half];
+					int* targetCount = &halfIndexCounts[half];
+
+					targetIndices[(*targetCount)++] = splitVertices[split.corners[j][0]];
+					targetIndices[(*targetCount)++] = splitVertices[split.corners[j][1]];
+					targetIndices[(*targetCount)++] = splitVertices[split.corners[j][2]];
+				}
+			}
+
+			for (int i = 0; i < 2; ++i)
+				if (halves[i] != nullptr)
+					writeHalf(halves[i], newVertices, newNormals, newVertexCount, halfIndices[i], halfIndexCounts[i]);
+
+			delete[] halfIndices[0];
+			delete[] halfIndices[1];
+
+			delete[] newVertices;
+			delete[] newNormals;
+
+			delete[] distances;
+			delete[] sides;
+		}
+
+		// Keeps the chunks that have any faces, freeing the rest
+		void takeChunks(std::vector<MeshChunk*>* target, std::vector<MeshChunk*>* chunks)
+		{
+			for (size_t i = 0; i < chunks->size(); ++i)
+			{
+				if ((*chunks)[i]->indexCount > 0)
+					target->push_back((*chunks)[i]);
+				else
+					delete (*chunks)[i];
+			}
+		}
+	}
+
+	MeshChunk::MeshChunk()
+		: vertices(nullptr), vertexNormals(nullptr), vertexCount(0), shortIndices(nullptr), longIndices(nullptr), indexCount(0)
+	{
+
+	}
+
+	MeshChunk::~MeshChunk()
+	{
+		delete[] vertices;
+		delete[] vertexNormals;
+		delete[] shortIndices;
+		delete[] longIndices;
+	}
+
+	ChunkedMesh::ChunkedMesh()
+	{
+
+	}
+
+	ChunkedMesh::~ChunkedMesh()
+	{
+		clear();
+	}
+
+	void ChunkedMesh::fromMesh(const Mesh* mesh)
+	{
+		clear();
+
+		int faceCount = mesh->indexCount / 3;
+		bool hasNormals = mesh->vertexNormals != nullptr;
+
+		// Local index of each mesh vertex in the chunk being filled, or -1
+		int* remap = new int[mesh->vertexCount > 0 ? mesh->vertexCount : 1];
+		std::vector<int> chunkVertices;
+
+		for (int i = 0; i < mesh->vertexCount; ++i)
+			remap[i] = -1;
+
+		int firstFace = 0;
+
+		for (int i = 0; i <= faceCount; ++i)
+		{
+			const int* face = &mesh->indices[i * 3];
+			int newVertices = 0;
+
+			if (i < faceCount)
+			{
+				for (int k = 0; k < 3; ++k)
+					if (remap[face[k]] == -1 && (k == 0 || face[k] != face[0]) && (k < 2 || face[k] != face[1]))
+						newVertices++;
+			}
+
+			// Close the chunk once the next face won't fit, or at the end
+			if (i == faceCount || (int)chunkVertices.size() + newVertices > CHUNK_VERTICES)
+			{
+				if (i > firstFace)
+				{
+					MeshChunk* chunk = getChunk(addChunk((int)chunkVertices.size(), (i - firstFace) * 3, hasNormals));
+
+					for (int j = 0; j < (int)chunkVertices.size(); ++j)
+					{
+						chunk->vertices[j] = mesh->vertices[chunkVertices[j]];
+
+						if (hasNormals)
+							chunk->vertexNormals[j] = mesh->vertexNormals[chunkVertices[j]];
+					}
+
+					for (int j = firstFace * 3; j < i * 3; ++j)
+						setIndex(chunk, j - firstFace * 3, remap[mesh->indices[j]]);
+				}
+
+				for (int j = 0; j < (int)chunkVertices.size(); ++j)
+					remap[chunkVertices[j]] = -1;
+
+				chunkVertices.clear();
+				firstFace = i;
+			}
+
+			if (i == faceCount)
+				break;
+
+			for (int k = 0; k < 3; ++k)
+			{
+				if (remap[face[k]] == -1)
+				{
+					remap[face[k]] = (int)chunkVertices.size();
+					chunkVertices.push_back(face[k]);
+				}
+			}
+		}
+
+		delete[] remap;
+	}
+
+	bool ChunkedMesh::toMesh(Mesh* mesh) const
+	{
+		long long vertexCount = getVertexCount();
+		long long indexCount = getIndexCount();
+
+		if (vertexCount > INT_MAX || indexCount > INT_MAX)
+			return false;
+
+		bool hasNormals = !chunks.empty();
+
+		for (size_t i = 0; i < chunks.size(); ++i)
+			if (chunks[i]->vertexNormals == nullptr)
+				hasNormals = false;
+
+		MemoryResource* resource = mesh->getMemoryResource();
+
+		freeArray(resource, mesh->vertices);
+		freeArray(resource, mesh->vertexNormals);
+		freeArray(resource, mesh->texCoords);
+		freeArray(resource, mesh->indices);
+
+		mesh->clearAdjacency();
+		mesh->markChanged();
+
+		mesh->vertices = allocateArray<Vector3>(resource, (size_t)vertexCount);
+		mesh->vertexNormals = hasNormals ? allocateArray<Vector3>(resource, (size_t)vertexCount) : nullptr;
+		mesh->texCoords = nullptr;
+		mesh->indices = allocateArray<int>(resource, (size_t)indexCount);
+
+		mesh->vertexCount = (int)vertexCount;
+		mesh->indexCount = (int)indexCount;
+		mesh->vertexCapacity = (int)vertexCount;
+		mesh->indexCapacity = (int)indexCount;
+
+		int firstVertex = 0;
+		int firstIndex = 0;
+
+		for (size_t i = 0; i < chunks.size(); ++i)
+		{
+			const MeshChunk* chunk = chunks[i];
+
+			memcpy(&mesh->vertices[firstVertex], chunk->vertices, chunk->vertexCount * sizeof(Vector3));
+
+			if (hasNormals)
+				memcpy(&mesh->vertexNormals[firstVertex], chunk->vertexNormals, chunk->vertexCount * sizeof(Vector3));
+
+			for (int j = 0; j < chunk->indexCount; ++j)
+				mesh->indices[firstIndex + j] = firstVertex + chunk->getIndex(j);
+
+			firstVertex += chunk->vertexCount;
+			firstIndex += chunk->indexCount;
+		}
+
+		return true;
+	}
+
+	int ChunkedMesh::addChunk(int vertexCount, int indexCount, bool hasNormals)
+	{
+		MeshChunk* chunk = new MeshChunk();
+		allocateChunk(chunk, vertexCount, indexCount, hasNormals);
+
+		chunks.push_back(chunk);
+
+		return (int)chunks.size() - 1;
+	}
+
+	void ChunkedMesh::clear()
+	{
+		for (size_t i = 0; i < chunks.size(); ++i)
+			delete chunks[i];
+
+		chunks.clear();
+	}
+
+	int ChunkedMesh::getChunkCount() const
+	{
+		return (int)chunks.size();
+	}
+
+	const MeshChunk* ChunkedMesh::getChunk(int chunk) const
+	{
+		return chunks[chunk];
+	}
+
+	MeshChunk* ChunkedMesh::getChunk(int chunk)
+	{
+		return chunks[chunk];
+	}
+
+	long long ChunkedMesh::getVertexCount() const
+	{
+		long long count = 0;
+
+		for (size_t i = 0; i < chunks.size(); ++i)
+			count += chunks[i]->vertexCount;
+
+		return count;
+	}
+
+	long long ChunkedMesh::getIndexCount() const
+	{
+		long long count = 0;
+
+		for (size_t i = 0; i < chunks.size(); ++i)
+			count += chunks[i]->indexCount;
+
+		return count;
+	}
+
+	void ChunkedMesh::cut(ChunkedMesh* left, ChunkedMesh* right, Vector3 planePoint, Vector3 planeNormal, const CutOptions& options, ThreadPool* pool) const
+	{
+		if (pool == nullptr)
+			pool = ThreadPool::getDefault();
+
+		// Distances are measured along a unit normal so that epsilon is in mesh units
+		if (length3(&planeNormal) > 0)
+			normalise3(&planeNormal, &planeNormal);
+
+		int chunkCount = (int)chunks.size();
+
+		std::vector<MeshChunk*> leftChunks(left != nullptr ? chunkCount : 0);
+		std::vector<MeshChunk*> rightChunks(right != nullptr ? chunkCount : 0);
+
+		for (size_t i = 0; i < leftChunks.size(); ++i)
+			leftChunks[i] = new MeshChunk();
+
+		for (size_t i = 0; i < rightChunks.size(); ++i)
+			rightChunks[i] = new MeshChunk();
+
+		pool->parallelFor(chunkCount, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i)
+				cutChunk(chunks[i], left != nullptr ? leftChunks[i] : nullptr, right != nullptr ? rightChunks[i] : nullptr, &planePoint, &planeNormal, options.epsilon);
+		});
+
+		// Only now that every chunk is cut can a half that is this mesh be replaced
+		if (left != nullptr)
+		{
+			left->clear();
+			takeChunks(&left->chunks, &leftChunks);
+		}
+
+		if (right != nullptr)
+		{
+			right->clear();
+			takeChunks(&right->chunks, &rightChunks);
+		}
+	}
+}
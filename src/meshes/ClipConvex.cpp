@@ -0,0 +1,363 @@
+#include "meshes/Mesh.h"
+
+#include "maths/VectorBatch.h"
+#include "memory/MemoryResource.h"
+#include "meshes/TriangleSplit.h"
+
+#include <string.h>
+#include <unordered_map>
+
+namespace cut
+{
+	namespace
+	{
+		// A corner of a face as it is clipped. Points on an edge of the source face remember the
+		// edge and the plane that made them, so the face on the other side of the edge can share
+		// them; points made inside the face belong to it alone.
+		struct ClipVertex
+		{
+			// Source vertex, or the ends of the source edge (lower first), or -1 inside the face
+			int edgeStart;
+			int edgeEnd;
+			int plane;
+
+			Vector3 position;
+			Vector3 normal;
+			Vector2 texCoord;
+
+			float distances[Mesh::MAX_CLIP_PLANES];
+		};
+
+		// Finds the source edge two corners of a clipped face both lie on, if there is one
+		bool getSharedEdge(const ClipVertex* first, const ClipVertex* second, int* start, int* end)
+		{
+			if (first->edgeStart == -1 || second->edgeStart == -1)
+				return false;
+
+			bool firstIsVertex = first->edgeStart == first->edgeEnd;
+			bool secondIsVertex = second->edgeStart == second->edgeEnd;
+
+			if (firstIsVertex && secondIsVertex)
+			{
+				*start = first->edgeStart < second->edgeStart ? first->edgeStart : second->edgeStart;
+				*end = first->edgeStart < second->edgeStart ? second->edgeStart : first->edgeStart;
+				return true;
+			}
+
+			if (firstIsVertex || secondIsVertex)
+			{
+				const ClipVertex* vertex = firstIsVertex ? first : second;
+				const ClipVertex* edge = firstIsVertex ? second : first;
+
+				if (vertex->edgeStart != edge->edgeStart && vertex->edgeStart != edge->edgeEnd)
+					return false;
+
+				*start = edge->edgeStart;
+				*end = edge->edgeEnd;
+				return true;
+			}
+
+			if (first->edgeStart != second->edgeStart || first->edgeEnd != second->edgeEnd)
+				return false;
+
+			*start = first->edgeStart;
+			*end = first->edgeEnd;
+			return true;
+		}
+
+		// Makes room in the result for the source's attributes, dropping any it doesn't have
+		void prepareResult(Mesh* result, const Mesh* source)
+		{
+			MemoryResource* resource = result->getMemoryResource();
+
+			result->clearAdjacency();
+			result->markChanged();
+
+			result->vertexCount = 0;
+			result->indexCount = 0;
+
+			if (source->vertexNormals != nullptr && result->vertexNormals == nullptr)
+				result->vertexNormals = allocateArray<Vector3>(resource, result->vertexCapacity);
+			else if (source->vertexNormals == nullptr && result->vertexNormals != nullptr)
+			{
+				freeArray(resource, result->vertexNormals);
+				result->vertexNormals = nullptr;
+			}
+
+			if (source->texCoords != nullptr && result->texCoords == nullptr)
+				result->texCoords = allocateArray<Vector2>(resource, result->vertexCapacity);
+			else if (source->texCoords == nullptr && result->texCoords != nullptr)
+			{
+				freeArray(resource, result->texCoords);
+				result->texCoords = nullptr;
+			}
+
+			result->reserve(source->vertexCount, source->indexCount);
+		}
+
+		int addVertex(Mesh* result, const ClipVertex* vertex)
+		{
+			result->reserve(result->vertexCount + 1, result->indexCount);
+
+			int index = result->vertexCount++;
+
+			result->vertices[index] = vertex->position;
+
+			if (result->vertexNormals != nullptr)
+				result->vertexNormals[index] = vertex->normal;
+
+			if (result->texCoords != nullptr)
+				result->texCoords[index] = vertex->texCoord;
+
+			return index;
+		}
+	}
+
+	bool Mesh::clipConvex(Mesh* result, const Vector3* planePoints, const Vector3* planeNormals, int planeCount, const CutOptions& options) const
+	{
+		if (planeCount > MAX_CLIP_PLANES || result == this)
+			return false;
+
+		int faceCount = indexCount / 3;
+		float epsilon = options.epsilon;
+
+		// Distances to every plane, and a bit for each plane a vertex is outside of
+		float* distances = new float[planeCount * vertexCount > 0 ? planeCount * vertexCount : 1];
+		unsigned int* outsideMasks = new unsigned int[vertexCount > 0 ? vertexCount : 1];
+
+		memset(outsideMasks, 0, vertexCount * sizeof(unsigned int));
+
+		for (int k = 0; k < planeCount; ++k)
+		{
+			Vector3 normal = planeNormals[k];
+
+			if (length3(&normal) > 0)
+				normalise3(&normal, &normal);
+
+			float* planeDistances = &distances[k * vertexCount];
+
+			planeDistanceBatch(vertices, &normal, &planePoints[k], planeDistances, vertexCount);
+
+			for (int i = 0; i < vertexCount; ++i)
+				if (classifyDistance(planeDistances[i], epsilon) == SIDE_RIGHT)
+					outsideMasks[i] |= 1u << k;
+		}
+
+		prepareResult(result, this);
+
+		// Source vertices are numbered as they are first used, and points on source edges once
+		// per edge and plane, so neighbouring faces share them
+		int* remap = new int[vertexCount > 0 ? vertexCount : 1];
+
+		for (int i = 0; i < vertexCount; ++i)
+			remap[i] = -1;
+
+		std::unordered_map<unsigned long long, int> edgeVertices;
+
+		ClipVertex polygons[2][3 + MAX_CLIP_PLANES];
+
+		for (int i = 0; i < faceCount; ++i)
+		{
+			const int* face = &indices[i*3];
+
+			unsigned int masks[3] = { outsideMasks[face[0]], outsideMasks[face[1]], outsideMasks[face[2]] };
+
+			// All outside one plane
+			if ((masks[0] & masks[1] & masks[2]) != 0)
+				continue;
+
+			unsigned int clipMask = masks[0] | masks[1] | masks[2];
+
+			// All inside every plane, so copied as it is
+			if (clipMask == 0)
+			{
+				result->reserve(result->vertexCount + 3, result->indexCount + 3);
+
+				for (int k = 0; k < 3; ++k)
+				{
+					int vertex = face[k];
+
+					if (remap[vertex] == -1)
+					{
+						int index = result->vertexCount++;
+
+						result->vertices[index] = vertices[vertex];
+
+						if (result->vertexNormals != nullptr)
+							result->vertexNormals[index] = vertexNormals[vertex];
+
+						if (result->texCoords != nullptr)
+							result->texCoords[index] = texCoords[vertex];
+
+						remap[vertex] = index;
+					}
+
+					result->indices[result->indexCount++] = remap[vertex];
+				}
+
+				continue;
+			}
+
+			ClipVertex* polygon = polygons[0];
+			ClipVertex* clipped = polygons[1];
+			int polygonCount = 3;
+
+			for (int k = 0; k < 3; ++k)
+			{
+				ClipVertex* corner = &polygon[k];
+
+				corner->edgeStart = face[k];
+				corner->edgeEnd = face[k];
+				corner->plane = -1;
+				corner->position = vertices[face[k]];
+
+				// Missing attributes are zero, so interpolating them is harmless
+				corner->normal.x = corner->normal.y = corner->normal.z = 0;
+				corner->texCoord.x = corner->texCoord.y = 0;
+
+				if (vertexNormals != nullptr)
+					corner->normal = vertexNormals[face[k]];
+
+				if (texCoords != nullptr)
+					corner->texCoord = texCoords[face[k]];
+
+				for (int j = 0; j < planeCount; ++j)
+					corner->distances[j] = distances[j * vertexCount + face[k]];
+			}
+
+			// Clip against only the planes some corner is outside of, Sutherland-Hodgman style
+			for (int k = 0; k < planeCount && polygonCount >= 3; ++k)
+			{
+				if ((clipMask & (1u << k)) == 0)
+					continue;
+
+				int clippedCount = 0;
+
+				for (int j = 0; j < polygonCount; ++j)
+				{
+					const ClipVertex* from = &polygon[j];
+					const ClipVertex* to = &polygon[(j + 1) % polygonCount];
+
+					PlaneSide fromSide = classifyDistance(from->distances[k], epsilon);
+					PlaneSide toSide = classifyDistance(to->distances[k], epsilon);
+
+					if (fromSide != SIDE_RIGHT)
+						clipped[clippedCount++] = *from;
+
+					// Corners on the plane are where the polygon crosses, so only a corner strictly
+					// either side of it makes a new point
+					if (!((fromSide == SIDE_LEFT && toSide == SIDE_RIGHT) || (fromSide == SIDE_RIGHT && toSide == SIDE_LEFT)))
+						continue;
+
+					ClipVertex* intersection = &clipped[clippedCount++];
+					int start, end;
+
+					if (getSharedEdge(from, to, &start, &end))
+					{
+						// Along a source edge, interpolate from its lower end as the other face will
+						float startDistance = distances[k * vertexCount + start];
+						float t = startDistance / (startDistance - distances[k * vertexCount + end]);
+
+						intersection->edgeStart = start;
+						intersection->edgeEnd = end;
+						intersection->plane = k;
+
+						lerp3(&vertices[start], &vertices[end], t, &intersection->position);
+
+						intersection->normal = from->normal;
+						intersection->texCoord = from->texCoord;
+
+						if (vertexNormals != nullptr)
+							lerp3(&vertexNormals[start], &vertexNormals[end], t, &intersection->normal);
+
+						if (texCoords != nullptr)
+						{
+							intersection->texCoord.x = texCoords[start].x + (texCoords[end].x - texCoords[start].x) * t;
+							intersection->texCoord.y = texCoords[start].y + (texCoords[end].y - texCoords[start].y) * t;
+						}
+
+						for (int l = 0; l < planeCount; ++l)
+						{
+							float lowDistance = distances[l * vertexCount + start];
+							intersection->distances[l] = lowDistance + (distances[l * vertexCount + end] - lowDistance) * t;
+						}
+					}
+					else
+					{
+						float t = from->distances[k] / (from->distances[k] - to->distances[k]);
+
+						intersection->edgeStart = -1;
+						intersection->edgeEnd = -1;
+						intersection->plane = k;
+
+						lerp3(&from->position, &to->position, t, &intersection->position);
+						lerp3(&from->normal, &to->normal, t, &intersection->normal);
+
+						intersection->texCoord.x = from->texCoord.x + (to->texCoord.x - from->texCoord.x) * t;
+						intersection->texCoord.y = from->texCoord.y + (to->texCoord.y - from->texCoord.y) * t;
+
+						for (int l = 0; l < planeCount; ++l)
+							intersection->distances[l] = from->distances[l] + (to->distances[l] - from->distances[l]) * t;
+					}
+				}
+
+				ClipVertex* temp = polygon;
+				polygon = clipped;
+				clipped = temp;
+
+				polygonCount = clippedCount;
+			}
+
+			if (polygonCount < 3)
+				continue;
+
+			// Only now that the polygon is final are its corners added to the result
+			int polygonIndices[3 + MAX_CLIP_PLANES];
+
+			for (int j = 0; j < polygonCount; ++j)
+			{
+				const ClipVertex* corner = &polygon[j];
+
+				if (corner->edgeStart == -1)
+					polygonIndices[j] = addVertex(result, corner);
+				else if (corner->edgeStart == corner->edgeEnd)
+				{
+					if (remap[corner->edgeStart] == -1)
+						remap[corner->edgeStart] = addVertex(result, corner);
+
+					polygonIndices[j] = remap[corner->edgeStart];
+				}
+				else
+				{
+					unsigned long long key = ((unsigned long long)corner->edgeStart * vertexCount + corner->edgeEnd) * planeCount + corner->plane;
+
+					std::unordered_map<unsigned long long, int>::iterator existing = edgeVertices.find(key);
+
+					if (existing != edgeVertices.end())
+						polygonIndices[j] = existing->second;
+					else
+					{
+						polygonIndices[j] = addVertex(result, corner);
+						edgeVertices[key] = polygonIndices[j];
+					}
+				}
+			}
+
+			// The polygon is convex, so a fan keeps the face's winding
+			result->reserve(result->vertexCount, result->indexCount + (polygonCount - 2) * 3);
+
+			for (int j = 1; j < polygonCount - 1; ++j)
+			{
+				result->indices[result->indexCount++] = polygonIndices[0];
+				result->indices[result->indexCount++] = polygonIndices[j];
+				result->indices[result->indexCount++] = polygonIndices[j + 1];
+			}
+		}
+
+		delete[] distances;
+		delete[] outsideMasks;
+		delete[] remap;
+
+		return true;
+	}
+}
@@ -0,0 +1,239 @@
+#include "meshes/ComponentSplitter.h"
+#include "meshes/Mesh.h"
+#include "memory/MemoryResource.h"
+#include "threading/ThreadPool.h"
+
+namespace cut
+{
+	namespace
+	{
+		// Follows parents to the root, halving the path on the way
+		int findRoot(std::atomic<int>* parents, int vertex)
+		{
+			for (;;)
+			{
+				int parent = parents[vertex].load(std::memory_order_relaxed);
+
+				if (parent == vertex)
+					return vertex;
+
+				int grandparent = parents[parent].load(std::memory_order_relaxed);
+
+				if (grandparent != parent)
+					parents[vertex].compare_exchange_weak(parent, grandparent, std::memory_order_relaxed);
+
+				vertex = grandparent;
+			}
+		}
+
+		// Roots only ever link to a lower root, so each component ends up rooted at its lowest
+		// vertex whatever order the threads get there in
+		void unite(std::atomic<int>* parents, int first, int second)
+		{
+			for (;;)
+			{
+				first = findRoot(parents, first);
+				second = findRoot(parents, second);
+
+				if (first == second)
+					return;
+
+				if (first < second)
+				{
+					int temp = first;
+					first = second;
+					second = temp;
+				}
+
+				int expected = first;
+
+				if (parents[first].compare_exchange_strong(expected, second, std::memory_order_relaxed))
+					return;
+			}
+		}
+
+		// Makes room in a component for the counts given, matching the attributes of the source
+		void prepareComponent(Mesh* component, const Mesh* source, int vertexCount, int indexCount)
+		{
+			MemoryResource* resource = component->getMemoryResource();
+
+			component->clearAdjacency();
+			component->markChanged();
+
+			component->vertexCount = 0;
+			component->indexCount = 0;
+
+			if (source->vertexNormals != nullptr && component->vertexNormals == nullptr)
+				component->vertexNormals = allocateArray<Vector3>(resource, component->vertexCapacity);
+			else if (source->vertexNormals == nullptr && component->vertexNormals != nullptr)
+			{
+				freeArray(resource, component->vertexNormals);
+				component->vertexNormals = nullptr;
+			}
+
+			if (source->texCoords != nullptr && component->texCoords == nullptr)
+				component->texCoords = allocateArray<Vector2>(resource, component->vertexCapacity);
+			else if (source->texCoords == nullptr && component->texCoords != nullptr)
+			{
+				freeArray(resource, component->texCoords);
+				component->texCoords = nullptr;
+			}
+
+			component->reserve(vertexCount, indexCount);
+
+			component->vertexCount = vertexCount;
+			component->indexCount = indexCount;
+		}
+	}
+
+	ComponentSplitter::ComponentSplitter(ThreadPool* pool)
+		: pool(pool != nullptr ? pool : ThreadPool::getDefault()),
+		  vertexCapacity(0), parents(nullptr), componentIds(nullptr), localIndices(nullptr), componentCount(0)
+	{
+
+	}
+
+	ComponentSplitter::~ComponentSplitter()
+	{
+		delete[] parents;
+		delete[] componentIds;
+		delete[] localIndices;
+
+		for (size_t i = 0; i < components.size(); ++i)
+			delete components[i];
+	}
+
+	int ComponentSplitter::split(const Mesh* mesh)
+	{
+		int vertexCount = mesh->vertexCount;
+		int faceCount = mesh->indexCount / 3;
+		const int* indices = mesh->indices;
+
+		reserve(vertexCount);
+
+		pool->parallelFor(vertexCount, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i)
+			{
+				parents[i].store(i, std::memory_order_relaxed);
+				componentIds[i] = -1;
+				localIndices[i] = -1;
+			}
+		});
+
+		// Join the corners of every face
+		pool->parallelFor(faceCount, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i)
+			{
+				unite(parents, indices[i * 3], indices[i * 3 + 1]);
+				unite(parents, indices[i * 3], indices[i * 3 + 2]);
+			}
+		});
+
+		// Point every vertex straight at its root
+		pool->parallelFor(vertexCount, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i)
+				parents[i].store(findRoot(parents, i), std::memory_order_relaxed);
+		});
+
+		// Number the components and their vertices in face order
+		componentCount = 0;
+		vertexCounts.clear();
+		faceCounts.clear();
+
+		for (int i = 0; i < faceCount; ++i)
+		{
+			int root = parents[indices[i * 3]].load(std::memory_order_relaxed);
+
+			if (componentIds[root] == -1)
+			{
+				componentIds[root] = componentCount++;
+				vertexCounts.push_back(0);
+				faceCounts.push_back(0);
+			}
+
+			int component = componentIds[root];
+
+			++faceCounts[component];
+
+			for (int j = 0; j < 3; ++j)
+			{
+				int vertex = indices[i * 3 + j];
+
+				if (localIndices[vertex] == -1)
+					localIndices[vertex] = vertexCounts[component]++;
+			}
+		}
+
+		while ((int)components.size() < componentCount)
+			components.push_back(new Mesh());
+
+		for (int i = 0; i < componentCount; ++i)
+			prepareComponent(components[i], mesh, vertexCounts[i], faceCounts[i] * 3);
+
+		// Scatter the vertices to their components
+		pool->parallelFor(vertexCount, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i)
+			{
+				if (localIndices[i] == -1)
+					continue;
+
+				Mesh* component = components[componentIds[parents[i].load(std::memory_order_relaxed)]];
+				int local = localIndices[i];
+
+				component->vertices[local] = mesh->vertices[i];
+
+				if (mesh->vertexNormals != nullptr)
+					component->vertexNormals[local] = mesh->vertexNormals[i];
+
+				if (mesh->texCoords != nullptr)
+					component->texCoords[local] = mesh->texCoords[i];
+			}
+		});
+
+		// Then the faces, which keep their order within each component
+		for (int i = 0; i < componentCount; ++i)
+			faceCounts[i] = 0;
+
+		for (int i = 0; i < faceCount; ++i)
+		{
+			int component = componentIds[parents[indices[i * 3]].load(std::memory_order_relaxed)];
+			int* target = &components[component]->indices[faceCounts[component]++ * 3];
+
+			target[0] = localIndices[indices[i * 3]];
+			target[1] = localIndices[indices[i * 3 + 1]];
+			target[2] = localIndices[indices[i * 3 + 2]];
+		}
+
+		return componentCount;
+	}
+
+	Mesh* ComponentSplitter::getComponent(int component) const
+	{
+		return components[component];
+	}
+
+	int ComponentSplitter::getComponentCount() const
+	{
+		return componentCount;
+	}
+
+	void ComponentSplitter::reserve(int vertexCount)
+	{
+		if (vertexCount <= vertexCapacity)
+			return;
+
+		delete[] parents;
+		delete[] componentIds;
+		delete[] localIndices;
+
+		vertexCapacity = vertexCount > vertexCapacity * 3 / 2 ? vertexCount : vertexCapacity * 3 / 2;
+
+		parents = new std::atomic<int>[vertexCapacity];
+		componentIds = new int[vertexCapacity];
+		localIndices = new int[vertexCapacity];
+	}
+}
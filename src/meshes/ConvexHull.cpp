@@ -0,0 +1,480 @@
+#include "meshes/ConvexHull.h"
+#include "meshes/Mesh.h"
+#include "memory/MemoryResource.h"
+
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+namespace cut
+{
+	ConvexHull::ConvexHull()
+		: points(nullptr), pointCount(0), epsilon(0), mark(0)
+	{
+
+	}
+
+	ConvexHull::~ConvexHull()
+	{
+
+	}
+
+	bool ConvexHull::build(const Vector3* points, int pointCount, Mesh* hull, int maxVertices)
+	{
+		this->points = points;
+		this->pointCount = pointCount;
+
+		faces.clear();
+		faceMarks.clear();
+		heap.clear();
+		outsideNext.assign(pointCount, -1);
+		vertexFaces.assign(pointCount, -1);
+
+		// Points closer to a face than this are treated as on it
+		float extent = 0;
+
+		for (int i = 0; i < pointCount; ++i)
+			for (int j = 0; j < 3; ++j)
+				extent = fabsf(points[i].data[j]) > extent ? fabsf(points[i].data[j]) : extent;
+
+		epsilon = extent * 3 * 3 * FLT_EPSILON;
+
+		if (!buildSimplex())
+		{
+			faces.clear();
+			writeMesh(hull);
+			return false;
+		}
+
+		if (maxVertices > 0 && maxVertices < 4)
+			maxVertices = 4;
+
+		int hullVertexCount = 4;
+
+		// Take the point furthest outside any face each time. Faces covered over since they
+		// were queued are skipped.
+		while (!heap.empty() && (maxVertices == 0 || hullVertexCount < maxVertices))
+		{
+			int best = heap.front().face;
+
+			std::pop_heap(heap.begin(), heap.end());
+			heap.pop_back();
+
+			if (!faces[best].alive)
+				continue;
+
+			addPoint(best, faces[best].furthest);
+			++hullVertexCount;
+		}
+
+		writeMesh(hull);
+		return true;
+	}
+
+	bool ConvexHull::build(const Mesh* mesh, Mesh* hull, int maxVertices)
+	{
+		hullIndices.assign(mesh->vertexCount, -1);
+		seed.clear();
+
+		for (int i = 0; i < mesh->indexCount; ++i)
+		{
+			if (hullIndices[mesh->indices[i]] != -1)
+				continue;
+
+			hullIndices[mesh->indices[i]] = 0;
+			seed.push_back(mesh->vertices[mesh->indices[i]]);
+		}
+
+		return build(seed.empty() ? nullptr : &seed[0], (int)seed.size(), hull, maxVertices);
+	}
+
+	bool ConvexHull::buildCutHull(const Mesh* sourceHull, const Mesh* half, int firstNewVertex, Vector3 planePoint, Vector3 planeNormal,
+		Mesh* hull, int maxVertices)
+	{
+		seed.clear();
+
+		for (int i = 0; i < sourceHull->vertexCount; ++i)
+		{
+			Vector3 offset;
+			sub3(&sourceHull->vertices[i], &planePoint, &offset);
+
+			if (dot3(&offset, &planeNormal) >= 0)
+				seed.push_back(sourceHull->vertices[i]);
+		}
+
+		for (int i = firstNewVertex; i < half->vertexCount; ++i)
+			seed.push_back(half->vertices[i]);
+
+		return build(seed.empty() ? nullptr : &seed[0], (int)seed.size(), hull, maxVertices);
+	}
+
+	bool ConvexHull::buildSimplex()
+	{
+		if (pointCount < 4)
+			return false;
+
+		// Start from the two most distant of the extreme points on each axis
+		int extremes[6] = { 0, 0, 0, 0, 0, 0 };
+
+		for (int i = 1; i < pointCount; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				if (points[i].data[j] < points[extremes[j * 2]].data[j])
+					extremes[j * 2] = i;
+
+				if (points[i].data[j] > points[extremes[j * 2 + 1]].data[j])
+					extremes[j * 2 + 1] = i;
+			}
+		}
+
+		int simplex[4] = { 0, 0, 0, 0 };
+		float bestDistance = -1;
+
+		for (int i = 0; i < 6; ++i)
+		{
+			for (int j = i + 1; j < 6; ++j)
+			{
+				Vector3 offset;
+				sub3(&points[extremes[j]], &points[extremes[i]], &offset);
+
+				float distance = dot3(&offset, &offset);
+
+				if (distance > bestDistance)
+				{
+					bestDistance = distance;
+					simplex[0] = extremes[i];
+					simplex[1] = extremes[j];
+				}
+			}
+		}
+
+		if (sqrtf(bestDistance) <= epsilon)
+			return false;
+
+		// Then the point furthest from the line between them
+		Vector3 line;
+		sub3(&points[simplex[1]], &points[simplex[0]], &line);
+
+		bestDistance = -1;
+
+		for (int i = 0; i < pointCount; ++i)
+		{
+			Vector3 offset, perpendicular;
+			sub3(&points[i], &points[simplex[0]], &offset);
+			cross3(&line, &offset, &perpendicular);
+
+			float distance = dot3(&perpendicular, &perpendicular);
+
+			if (distance > bestDistance)
+			{
+				bestDistance = distance;
+				simplex[2] = i;
+			}
+		}
+
+		if (sqrtf(bestDistance) / length3(&line) <= epsilon)
+			return false;
+
+		// And the point furthest from the plane through all three
+		Vector3 edge, normal;
+		sub3(&points[simplex[2]], &points[simplex[0]], &edge);
+		cross3(&line, &edge, &normal);
+		normalise3(&normal, &normal);
+
+		bestDistance = -1;
+
+		for (int i = 0; i < pointCount; ++i)
+		{
+			Vector3 offset;
+			sub3(&points[i], &points[simplex[0]], &offset);
+
+			float distance = fabsf(dot3(&offset, &normal));
+
+			if (distance > bestDistance)
+			{
+				bestDistance = distance;
+				simplex[3] = i;
+			}
+		}
+
+		if (bestDistance <= epsilon)
+			return false;
+
+		// Faces are wound so that (b - a) x (c - a) points out until they are written out
+		Vector3 offset;
+		sub3(&points[simplex[3]], &points[simplex[0]], &offset);
+
+		if (dot3(&offset, &normal) > 0)
+		{
+			int temp = simplex[1];
+			simplex[1] = simplex[2];
+			simplex[2] = temp;
+		}
+
+		int a = simplex[0], b = simplex[1], c = simplex[2], d = simplex[3];
+
+		addFace(a, b, c);
+		addFace(a, d, b);
+		addFace(b, d, c);
+		addFace(c, d, a);
+
+		// Link the faces across their shared edges
+		for (int i = 0; i < 4; ++i)
+			for (int k = 0; k < 3; ++k)
+				for (int j = 0; j < 4; ++j)
+					for (int l = 0; l < 3; ++l)
+						if (faces[i].vertices[k] == faces[j].vertices[(l + 1) % 3] && faces[i].vertices[(k + 1) % 3] == faces[j].vertices[l])
+							faces[i].neighbours[k] = j;
+
+		int simplexFaces[4] = { 0, 1, 2, 3 };
+
+		for (int i = 0; i < pointCount; ++i)
+			if (i != a && i != b && i != c && i != d)
+				assignOutside(i, simplexFaces, 4);
+
+		for (int i = 0; i < 4; ++i)
+			pushCandidate(i);
+
+		return true;
+	}
+
+	int ConvexHull::addFace(int a, int b, int c)
+	{
+		Face face;
+
+		face.vertices[0] = a;
+		face.vertices[1] = b;
+		face.vertices[2] = c;
+		face.neighbours[0] = face.neighbours[1] = face.neighbours[2] = -1;
+
+		Vector3 edge1, edge2;
+		sub3(&points[b], &points[a], &edge1);
+		sub3(&points[c], &points[a], &edge2);
+		cross3(&edge1, &edge2, &face.normal);
+
+		// A sliver face has no direction, and nothing is ever outside it
+		if (length3(&face.normal) > 0)
+			normalise3(&face.normal, &face.normal);
+
+		face.offset = dot3(&face.normal, &points[a]);
+
+		face.outsideHead = -1;
+		face.furthest = -1;
+		face.furthestDistance = 0;
+		face.alive = true;
+
+		faces.push_back(face);
+		faceMarks.push_back(0);
+
+		return (int)faces.size() - 1;
+	}
+
+	void ConvexHull::pushCandidate(int face)
+	{
+		if (faces[face].outsideHead == -1)
+			return;
+
+		Candidate candidate = { faces[face].furthestDistance, face };
+
+		heap.push_back(candidate);
+		std::push_heap(heap.begin(), heap.end());
+	}
+
+	float ConvexHull::distance(int face, int point) const
+	{
+		return dot3(&faces[face].normal, &points[point]) - faces[face].offset;
+	}
+
+	void ConvexHull::assignOutside(int point, const int* candidates, int candidateCount)
+	{
+		int best = -1;
+		float bestDistance = epsilon;
+
+		for (int i = 0; i < candidateCount; ++i)
+		{
+			float pointDistance = distance(candidates[i], point);
+
+			if (pointDistance > bestDistance)
+			{
+				bestDistance = pointDistance;
+				best = candidates[i];
+			}
+		}
+
+		// Inside the hull, so it can be forgotten
+		if (best == -1)
+			return;
+
+		Face& face = faces[best];
+
+		outsideNext[point] = face.outsideHead;
+		face.outsideHead = point;
+
+		if (face.furthest == -1 || bestDistance > face.furthestDistance)
+		{
+			face.furthest = point;
+			face.furthestDistance = bestDistance;
+		}
+	}
+
+	void ConvexHull::findHorizon(int firstFace, int eye)
+	{
+		visible.clear();
+		horizonFrom.clear();
+		horizonTo.clear();
+		horizonFace.clear();
+		stack.clear();
+
+		++mark;
+
+		faceMarks[firstFace] = mark;
+		stack.push_back(firstFace);
+
+		// Flood out over the faces the eye can see. Edges to faces it can't see make the horizon.
+		while (!stack.empty())
+		{
+			int face = stack.back();
+			stack.pop_back();
+
+			visible.push_back(face);
+
+			for (int k = 0; k < 3; ++k)
+			{
+				int neighbour = faces[face].neighbours[k];
+
+				if (faceMarks[neighbour] == mark)
+					continue;
+
+				if (distance(neighbour, eye) > epsilon)
+				{
+					faceMarks[neighbour] = mark;
+					stack.push_back(neighbour);
+				}
+				else
+				{
+					horizonFrom.push_back(faces[face].vertices[k]);
+					horizonTo.push_back(faces[face].vertices[(k + 1) % 3]);
+					horizonFace.push_back(neighbour);
+				}
+			}
+		}
+	}
+
+	void ConvexHull::addPoint(int firstFace, int eye)
+	{
+		findHorizon(firstFace, eye);
+
+		// Fan new faces from the eye to each edge of the horizon
+		newFaces.clear();
+
+		for (int i = 0; i < (int)horizonFrom.size(); ++i)
+		{
+			int face = addFace(horizonFrom[i], horizonTo[i], eye);
+			int neighbour = horizonFace[i];
+
+			faces[face].neighbours[0] = neighbour;
+
+			for (int k = 0; k < 3; ++k)
+				if (faces[neighbour].vertices[k] == horizonTo[i] && faces[neighbour].vertices[(k + 1) % 3] == horizonFrom[i])
+					faces[neighbour].neighbours[k] = face;
+
+			vertexFaces[horizonFrom[i]] = face;
+			newFaces.push_back(face);
+		}
+
+		// Each new face meets the one starting where its horizon edge ends
+		for (int i = 0; i < (int)newFaces.size(); ++i)
+		{
+			int next = vertexFaces[horizonTo[i]];
+
+			faces[newFaces[i]].neighbours[1] = next;
+			faces[next].neighbours[2] = newFaces[i];
+		}
+
+		for (int i = 0; i < (int)horizonFrom.size(); ++i)
+			vertexFaces[horizonFrom[i]] = -1;
+
+		// Hand the points outside the faces that were covered over to the new ones
+		for (int i = 0; i < (int)visible.size(); ++i)
+		{
+			Face& face = faces[visible[i]];
+			face.alive = false;
+
+			int point = face.outsideHead;
+			face.outsideHead = -1;
+
+			while (point != -1)
+			{
+				int next = outsideNext[point];
+
+				if (point != eye)
+					assignOutside(point, &newFaces[0], (int)newFaces.size());
+
+				point = next;
+			}
+		}
+
+		for (int i = 0; i < (int)newFaces.size(); ++i)
+			pushCandidate(newFaces[i]);
+	}
+
+	void ConvexHull::writeMesh(Mesh* hull)
+	{
+		hullIndices.assign(pointCount, -1);
+
+		int vertexCount = 0;
+		int indexCount = 0;
+
+		for (int i = 0; i < (int)faces.size(); ++i)
+		{
+			if (!faces[i].alive)
+				continue;
+
+			for (int k = 0; k < 3; ++k)
+				if (hullIndices[faces[i].vertices[k]] == -1)
+					hullIndices[faces[i].vertices[k]] = vertexCount++;
+
+			indexCount += 3;
+		}
+
+		MemoryResource* resource = hull->getMemoryResource();
+
+		freeArray(resource, hull->vertices);
+		freeArray(resource, hull->vertexNormals);
+		freeArray(resource, hull->indices);
+		freeArray(resource, hull->texCoords);
+
+		hull->clearAdjacency();
+		hull->markChanged();
+
+		hull->vertices = allocateArray<Vector3>(resource, vertexCount);
+		hull->vertexNormals = nullptr;
+		hull->indices = allocateArray<int>(resource, indexCount);
+		hull->texCoords = nullptr;
+
+		hull->vertexCount = vertexCount;
+		hull->indexCount = indexCount;
+		hull->vertexCapacity = vertexCount;
+		hull->indexCapacity = indexCount;
+
+		for (int i = 0; i < pointCount; ++i)
+			if (hullIndices[i] != -1)
+				hull->vertices[hullIndices[i]] = points[i];
+
+		// Meshes are wound the other way round, with the outward normal along (c - a) x (b - a)
+		int* target = hull->indices;
+
+		for (int i = 0; i < (int)faces.size(); ++i)
+		{
+			if (!faces[i].alive)
+				continue;
+
+			*target++ = hullIndices[faces[i].vertices[0]];
+			*target++ = hullIndices[faces[i].vertices[2]];
+			*target++ = hullIndices[faces[i].vertices[1]];
+		}
+
+		hull->calculateNormals();
+	}
+}
@@ -0,0 +1,228 @@
+#include "meshes/CutCache.h"
+
+#include "meshes/CutPlan.h"
+
+#include <math.h>
+
+namespace cut
+{
+	namespace
+	{
+		const int FLAG_DECIMATE = 1;
+		const int FLAG_OPTIMISE = 2;
+		const int FLAG_MASS = 4;
+
+		size_t getMeshBytes(const Mesh* mesh)
+		{
+			size_t vertexSize = sizeof(Vector3);
+
+			if (mesh->vertexNormals != nullptr)
+				vertexSize += sizeof(Vector3);
+
+			if (mesh->texCoords != nullptr)
+				vertexSize += sizeof(Vector2);
+
+			size_t indexSize = mesh->opposites != nullptr ? sizeof(int) * 2 : sizeof(int);
+
+			return (size_t)mesh->vertexCapacity * vertexSize + (size_t)mesh->indexCapacity * indexSize;
+		}
+	}
+
+	bool CutCache::Key::operator==(const Key& other) const
+	{
+		return normal[0] == other.normal[0] && normal[1] == other.normal[1] && normal[2] == other.normal[2] && offset == other.offset
+			&& epsilon == other.epsilon && faceBudget == other.faceBudget && decimationError == other.decimationError && flags == other.flags;
+	}
+
+	size_t CutCache::KeyHash::operator()(const Key& key) const
+	{
+		unsigned long long hash = (unsigned long long)key.offset;
+
+		for (int i = 0; i < 3; ++i)
+			hash = hash * 0x100000001b3ull + (unsigned int)key.normal[i];
+
+		hash = hash * 0x100000001b3ull + (unsigned int)key.faceBudget;
+		hash = hash * 0x100000001b3ull + (unsigned int)key.flags;
+
+		return (size_t)(hash ^ (hash >> 32));
+	}
+
+	CutCache::CutCache(const Mesh* mesh, int maxEntries, size_t maxBytes, float positionStep, float normalStep)
+		: mesh(mesh), maxEntries(maxEntries > 0 ? maxEntries : 1), maxBytes(maxBytes), positionStep(positionStep), normalStep(normalStep),
+		  version(mesh->getVersion()), memoryBytes(0), hitCount(0), missCount(0)
+	{
+
+	}
+
+	CutCache::~CutCache()
+	{
+
+	}
+
+	std::shared_ptr<const CutResult> CutCache::cut(Vector3 planePoint, Vector3 planeNormal, const CutOptions& options)
+	{
+		Key key = makeKey(planePoint, planeNormal, options);
+		std::shared_ptr<const CutResult> result;
+		unsigned int cutVersion;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			checkVersion();
+			cutVersion = version;
+
+			std::unordered_map<Key, EntryList::iterator, KeyHash>::iterator found = lookup.find(key);
+
+			if (found != lookup.end())
+			{
+				// Move to the front as the most recently used
+				entries.splice(entries.begin(), entries, found->second);
+				result = found->second->result;
+				hitCount++;
+			}
+			else
+				missCount++;
+		}
+
+		if (result == nullptr)
+		{
+			// Cut without holding the lock, so other planes can be looked up meanwhile
+			CutResult* cutResult = new CutResult();
+			CutOptions cutOptions = options;
+
+			cutResult->hasMass = options.leftMass != nullptr || options.rightMass != nullptr;
+			cutOptions.leftMass = cutResult->hasMass ? &cutResult->leftMass : nullptr;
+			cutOptions.rightMass = cutResult->hasMass ? &cutResult->rightMass : nullptr;
+
+			CutPlan plan;
+			mesh->planCut(&plan, planePoint, planeNormal, cutOptions);
+			mesh->materialiseCut(&plan, &cutResult->left, &cutResult->right, cutOptions);
+
+			result.reset(cutResult);
+
+			std::lock_guard<std::mutex> lock(mutex);
+
+			checkVersion();
+
+			// Halves of a mesh that changed during the cut are still handed back, but not kept.
+			// Another thread may also have made the same cut in the meantime.
+			if (version == cutVersion && lookup.find(key) == lookup.end())
+			{
+				Entry entry;
+				entry.key = key;
+				entry.result = result;
+				entry.bytes = getMeshBytes(&cutResult->left) + getMeshBytes(&cutResult->right);
+
+				entries.push_front(entry);
+				lookup[key] = entries.begin();
+				memoryBytes += entry.bytes;
+
+				evict();
+			}
+		}
+
+		if (options.leftMass != nullptr)
+			*options.leftMass = result->leftMass;
+
+		if (options.rightMass != nullptr)
+			*options.rightMass = result->rightMass;
+
+		return result;
+	}
+
+	void CutCache::clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		entries.clear();
+		lookup.clear();
+		memoryBytes = 0;
+	}
+
+	long long CutCache::getHitCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return hitCount;
+	}
+
+	long long CutCache::getMissCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return missCount;
+	}
+
+	double CutCache::getHitRate() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		long long lookups = hitCount + missCount;
+
+		return lookups > 0 ? (double)hitCount / (double)lookups : 0.0;
+	}
+
+	int CutCache::getEntryCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return (int)entries.size();
+	}
+
+	size_t CutCache::getMemoryBytes() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return memoryBytes;
+	}
+
+	CutCache::Key CutCache::makeKey(Vector3 planePoint, Vector3 planeNormal, const CutOptions& options) const
+	{
+		Key key;
+
+		// The same plane can be given by any point on it, so only its distance from the origin counts
+		if (length3(&planeNormal) > 0)
+			normalise3(&planeNormal, &planeNormal);
+
+		for (int i = 0; i < 3; ++i)
+			key.normal[i] = (int)floorf(planeNormal.data[i] / normalStep + 0.5f);
+
+		key.offset = (long long)floor((double)dot3(&planeNormal, &planePoint) / positionStep + 0.5);
+
+		key.epsilon = options.epsilon;
+		key.faceBudget = options.decimator != nullptr ? options.faceBudget : 0;
+		key.decimationError = options.decimator != nullptr ? options.decimationError : 0.0f;
+
+		key.flags = 0;
+
+		if (options.decimator != nullptr)
+			key.flags |= FLAG_DECIMATE;
+
+		if (options.optimiser != nullptr)
+			key.flags |= FLAG_OPTIMISE;
+
+		if (options.leftMass != nullptr || options.rightMass != nullptr)
+			key.flags |= FLAG_MASS;
+
+		return key;
+	}
+
+	void CutCache::checkVersion()
+	{
+		if (mesh->getVersion() == version)
+			return;
+
+		entries.clear();
+		lookup.clear();
+		memoryBytes = 0;
+
+		version = mesh->getVersion();
+	}
+
+	void CutCache::evict()
+	{
+		// Keep the newest entry even if it's over the byte limit on its own
+		while (entries.size() > 1 && ((int)entries.size() > maxEntries || (maxBytes > 0 && memoryBytes > maxBytes)))
+		{
+			lookup.erase(entries.back().key);
+			memoryBytes -= entries.back().bytes;
+			entries.pop_back();
+		}
+	}
+}
@@ -0,0 +1,45 @@
+#include "meshes/CutPlan.h"
+
+namespace cut
+{
+	CutPlan::CutPlan()
+		: vertexCount(0), faceCount(0), distances(nullptr), vertexSides(nullptr), faceSides(nullptr), crossingFaces(nullptr),
+		  leftFaceCount(0), rightFaceCount(0), crossingFaceCount(0), vertexCapacity(0), faceCapacity(0)
+	{
+		planePoint.x = planePoint.y = planePoint.z = 0;
+		planeNormal.x = planeNormal.y = planeNormal.z = 0;
+	}
+
+	CutPlan::~CutPlan()
+	{
+		delete[] distances;
+		delete[] vertexSides;
+		delete[] faceSides;
+		delete[] crossingFaces;
+	}
+
+	void CutPlan::reserve(int newVertexCount, int newFaceCount)
+	{
+		if (newVertexCount > vertexCapacity)
+		{
+			delete[] distances;
+			delete[] vertexSides;
+
+			vertexCapacity = newVertexCount > vertexCapacity * 3 / 2 ? newVertexCount : vertexCapacity * 3 / 2;
+
+			distances = new float[vertexCapacity];
+			vertexSides = new PlaneSide[vertexCapacity];
+		}
+
+		if (newFaceCount > faceCapacity)
+		{
+			delete[] faceSides;
+			delete[] crossingFaces;
+
+			faceCapacity = newFaceCount > faceCapacity * 3 / 2 ? newFaceCount : faceCapacity * 3 / 2;
+
+			faceSides = new PlaneSide[faceCapacity];
+			crossingFaces = new int[faceCapacity];
+		}
+	}
+}
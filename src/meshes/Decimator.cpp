@@ -0,0 +1,522 @@
+#include "meshes/Decimator.h"
+#include "meshes/Mesh.h"
+
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+namespace cut
+{
+	namespace
+	{
+		// How much more it costs to move a vertex off an open boundary than off a surface
+		const double BOUNDARY_WEIGHT = 1000.0;
+
+		// The upper triangle of a 4x4 matrix, then the total weight of the surface planes in it
+		const int QUADRIC_SIZE = 11;
+
+		// Adds the plane n.x + d = 0 to a quadric
+		void addPlane(double* quadric, double nx, double ny, double nz, double d, double weight)
+		{
+			quadric[0] += weight * nx * nx;
+			quadric[1] += weight * nx * ny;
+			quadric[2] += weight * nx * nz;
+			quadric[3] += weight * nx * d;
+			quadric[4] += weight * ny * ny;
+			quadric[5] += weight * ny * nz;
+			quadric[6] += weight * ny * d;
+			quadric[7] += weight * nz * nz;
+			quadric[8] += weight * nz * d;
+			quadric[9] += weight * d * d;
+		}
+
+		// Mean squared distance from the surface planes, with open boundaries counting extra
+		double evaluate(const double* quadric, const Vector3* point)
+		{
+			double x = point->x, y = point->y, z = point->z;
+
+			if (quadric[10] <= 0)
+				return 0;
+
+			return (quadric[0] * x * x + 2.0 * quadric[1] * x * y + 2.0 * quadric[2] * x * z + 2.0 * quadric[3] * x
+				+ quadric[4] * y * y + 2.0 * quadric[5] * y * z + 2.0 * quadric[6] * y
+				+ quadric[7] * z * z + 2.0 * quadric[8] * z
+				+ quadric[9]) / quadric[10];
+		}
+
+		void faceNormal(const Vector3* a, const Vector3* b, const Vector3* c, Vector3* result)
+		{
+			Vector3 edge1, edge2;
+
+			sub3(c, a, &edge1);
+			sub3(b, a, &edge2);
+			cross3(&edge1, &edge2, result);
+		}
+	}
+
+	Decimator::Decimator()
+		: vertexCapacity(0), faceCapacity(0),
+		  adjacencyStarts(nullptr), adjacency(nullptr), chainNext(nullptr), chainTail(nullptr),
+		  quadrics(nullptr), quadricReady(nullptr), removed(nullptr), inRegion(nullptr), versions(nullptr), marks(nullptr), mark(0),
+		  alive(nullptr)
+	{
+
+	}
+
+	Decimator::~Decimator()
+	{
+		delete[] adjacencyStarts;
+		delete[] adjacency;
+		delete[] chainNext;
+		delete[] chainTail;
+		delete[] quadrics;
+		delete[] quadricReady;
+		delete[] removed;
+		delete[] inRegion;
+		delete[] versions;
+		delete[] marks;
+		delete[] alive;
+	}
+
+	void Decimator::decimate(Mesh* mesh, int targetFaceCount, int firstCandidateVertex, float maxError)
+	{
+		int vertexCount = mesh->vertexCount;
+		int faceCount = mesh->indexCount / 3;
+		int* indices = mesh->indices;
+
+		if (faceCount <= targetFaceCount)
+			return;
+
+		reserve(vertexCount, faceCount);
+
+		mesh->clearAdjacency();
+		mesh->markChanged();
+
+		// Faces around each vertex, by counting sort
+		memset(adjacencyStarts, 0, (vertexCount + 1) * sizeof(int));
+
+		for (int i = 0; i < faceCount * 3; ++i)
+			++adjacencyStarts[indices[i] + 1];
+
+		for (int i = 0; i < vertexCount; ++i)
+			adjacencyStarts[i + 1] += adjacencyStarts[i];
+
+		for (int i = 0; i < vertexCount; ++i)
+			chainTail[i] = adjacencyStarts[i];
+
+		for (int i = 0; i < faceCount * 3; ++i)
+			adjacency[chainTail[indices[i]]++] = i / 3;
+
+		for (int i = 0; i < vertexCount; ++i)
+		{
+			chainNext[i] = -1;
+			chainTail[i] = i;
+		}
+
+		memset(quadricReady, 0, vertexCount * sizeof(bool));
+		memset(removed, 0, vertexCount * sizeof(bool));
+		memset(inRegion, 0, vertexCount * sizeof(bool));
+		memset(versions, 0, vertexCount * sizeof(int));
+		memset(marks, 0, vertexCount * sizeof(int));
+		mark = 0;
+
+		// Only vertices on faces that touch the candidate vertices may be removed
+		for (int i = 0; i < faceCount; ++i)
+		{
+			const int* face = &indices[i * 3];
+
+			alive[i] = true;
+
+			if (face[0] >= firstCandidateVertex || face[1] >= firstCandidateVertex || face[2] >= firstCandidateVertex)
+				inRegion[face[0]] = inRegion[face[1]] = inRegion[face[2]] = true;
+		}
+
+		heap.clear();
+
+		for (int i = 0; i < vertexCount; ++i)
+			if (inRegion[i])
+				pushCollapses(mesh, i);
+
+		int aliveFaceCount = faceCount;
+
+		while (aliveFaceCount > targetFaceCount && !heap.empty())
+		{
+			std::pop_heap(heap.begin(), heap.end());
+			Collapse collapse = heap.back();
+			heap.pop_back();
+
+			// Everything left costs more than allowed
+			if (collapse.cost > maxError * maxError)
+				break;
+
+			int from = collapse.from;
+			int to = collapse.to;
+
+			// Skip collapses made stale by earlier ones
+			if (removed[from] || removed[to] || versions[from] != collapse.fromVersion || versions[to] != collapse.toVersion)
+				continue;
+
+			if (!canCollapse(mesh, from, to))
+				continue;
+
+			const double* fromQuadric = getQuadric(mesh, from);
+			getQuadric(mesh, to);
+
+			// Remove the faces on the edge and move the rest onto the remaining vertex
+			for (int c = from; c != -1; c = chainNext[c])
+			{
+				for (int i = adjacencyStarts[c]; i < adjacencyStarts[c + 1]; ++i)
+				{
+					int face = adjacency[i];
+
+					if (!alive[face])
+						continue;
+
+					int* corners = &indices[face * 3];
+
+					if (corners[0] == to || corners[1] == to || corners[2] == to)
+					{
+						alive[face] = false;
+						--aliveFaceCount;
+						continue;
+					}
+
+					for (int j = 0; j < 3; ++j)
+						if (corners[j] == from)
+							corners[j] = to;
+				}
+			}
+
+			double* toQuadric = &quadrics[to * QUADRIC_SIZE];
+
+			for (int i = 0; i < QUADRIC_SIZE; ++i)
+				toQuadric[i] += fromQuadric[i];
+
+			chainNext[chainTail[to]] = from;
+			chainTail[to] = chainTail[from];
+
+			removed[from] = true;
+			++versions[to];
+
+			pushCollapses(mesh, to);
+		}
+
+		// Compact the faces and the vertices still in use, keeping their order
+		int indexCount = 0;
+
+		for (int i = 0; i < faceCount; ++i)
+		{
+			if (!alive[i])
+				continue;
+
+			indices[indexCount++] = indices[i * 3 + 0];
+			indices[indexCount++] = indices[i * 3 + 1];
+			indices[indexCount++] = indices[i * 3 + 2];
+		}
+
+		int* remap = versions;
+
+		memset(remap, 0xff, vertexCount * sizeof(int));
+
+		for (int i = 0; i < indexCount; ++i)
+			remap[indices[i]] = 0;
+
+		int usedCount = 0;
+
+		for (int i = 0; i < vertexCount; ++i)
+		{
+			if (remap[i] < 0)
+				continue;
+
+			remap[i] = usedCount;
+
+			mesh->vertices[usedCount] = mesh->vertices[i];
+
+			if (mesh->vertexNormals != nullptr)
+				mesh->vertexNormals[usedCount] = mesh->vertexNormals[i];
+
+			if (mesh->texCoords != nullptr)
+				mesh->texCoords[usedCount] = mesh->texCoords[i];
+
+			++usedCount;
+		}
+
+		for (int i = 0; i < indexCount; ++i)
+			indices[i] = remap[indices[i]];
+
+		mesh->indexCount = indexCount;
+		mesh->vertexCount = usedCount;
+	}
+
+	const double* Decimator::getQuadric(const Mesh* mesh, int vertex)
+	{
+		double* quadric = &quadrics[vertex * QUADRIC_SIZE];
+
+		if (quadricReady[vertex])
+			return quadric;
+
+		quadricReady[vertex] = true;
+
+		memset(quadric, 0, QUADRIC_SIZE * sizeof(double));
+
+		for (int c = vertex; c != -1; c = chainNext[c])
+		{
+			for (int i = adjacencyStarts[c]; i < adjacencyStarts[c + 1]; ++i)
+			{
+				int face = adjacency[i];
+
+				if (!alive[face])
+					continue;
+
+				const int* corners = &mesh->indices[face * 3];
+				const Vector3* a = &mesh->vertices[corners[0]];
+
+				Vector3 normal;
+				faceNormal(a, &mesh->vertices[corners[1]], &mesh->vertices[corners[2]], &normal);
+
+				float length = length3(&normal);
+
+				if (length <= 0)
+					continue;
+
+				normalise3(&normal, &normal);
+
+				// Planes are weighted by face area
+				addPlane(quadric, normal.x, normal.y, normal.z, -dot3(&normal, a), length * 0.5);
+				quadric[10] += length * 0.5;
+
+				// Open edges get a plane through them at right angles to the face
+				for (int j = 0; j < 3; ++j)
+				{
+					int first = corners[j];
+					int second = corners[(j + 1) % 3];
+
+					if ((first != vertex && second != vertex) || countFacesWith(mesh, first, second) != 1)
+						continue;
+
+					Vector3 edge, edgeNormal;
+					sub3(&mesh->vertices[second], &mesh->vertices[first], &edge);
+					cross3(&edge, &normal, &edgeNormal);
+
+					float edgeLength = length3(&edgeNormal);
+
+					if (edgeLength <= 0)
+						continue;
+
+					normalise3(&edgeNormal, &edgeNormal);
+
+					addPlane(quadric, edgeNormal.x, edgeNormal.y, edgeNormal.z, -dot3(&edgeNormal, &mesh->vertices[first]), BOUNDARY_WEIGHT * dot3(&edge, &edge));
+				}
+			}
+		}
+
+		return quadric;
+	}
+
+	int Decimator::countFacesWith(const Mesh* mesh, int vertex, int other)
+	{
+		int count = 0;
+
+		for (int c = vertex; c != -1; c = chainNext[c])
+		{
+			for (int i = adjacencyStarts[c]; i < adjacencyStarts[c + 1]; ++i)
+			{
+				int face = adjacency[i];
+
+				const int* corners = &mesh->indices[face * 3];
+
+				if (alive[face] && (corners[0] == other || corners[1] == other || corners[2] == other))
+					++count;
+			}
+		}
+
+		return count;
+	}
+
+	void Decimator::pushCollapses(const Mesh* mesh, int vertex)
+	{
+		int neighbourMark = ++mark;
+
+		for (int c = vertex; c != -1; c = chainNext[c])
+		{
+			for (int i = adjacencyStarts[c]; i < adjacencyStarts[c + 1]; ++i)
+			{
+				int face = adjacency[i];
+
+				if (!alive[face])
+					continue;
+
+				for (int j = 0; j < 3; ++j)
+				{
+					int other = mesh->indices[face * 3 + j];
+
+					if (other == vertex || marks[other] == neighbourMark)
+						continue;
+
+					marks[other] = neighbourMark;
+
+					pushCollapse(mesh, vertex, other);
+					pushCollapse(mesh, other, vertex);
+				}
+			}
+		}
+	}
+
+	void Decimator::pushCollapse(const Mesh* mesh, int from, int to)
+	{
+		if (!inRegion[from] || removed[from])
+			return;
+
+		const double* fromQuadric = getQuadric(mesh, from);
+		const double* toQuadric = getQuadric(mesh, to);
+
+		double quadric[QUADRIC_SIZE];
+
+		for (int i = 0; i < QUADRIC_SIZE; ++i)
+			quadric[i] = fromQuadric[i] + toQuadric[i];
+
+		Collapse collapse;
+		collapse.cost = (float)evaluate(quadric, &mesh->vertices[to]);
+		collapse.from = from;
+		collapse.to = to;
+		collapse.fromVersion = versions[from];
+		collapse.toVersion = versions[to];
+
+		heap.push_back(collapse);
+		std::push_heap(heap.begin(), heap.end());
+	}
+
+	bool Decimator::canCollapse(const Mesh* mesh, int from, int to)
+	{
+		const int* indices = mesh->indices;
+
+		// Mark the neighbours of the vertex being removed
+		int neighbourMark = ++mark;
+		int sharedFaceCount = 0;
+
+		for (int c = from; c != -1; c = chainNext[c])
+		{
+			for (int i = adjacencyStarts[c]; i < adjacencyStarts[c + 1]; ++i)
+			{
+				int face = adjacency[i];
+
+				if (!alive[face])
+					continue;
+
+				const int* corners = &indices[face * 3];
+
+				if (corners[0] == to || corners[1] == to || corners[2] == to)
+					++sharedFaceCount;
+
+				marks[corners[0]] = marks[corners[1]] = marks[corners[2]] = neighbourMark;
+			}
+		}
+
+		if (sharedFaceCount == 0)
+			return false;
+
+		// The ends of the edge must have no neighbours in common other than those across the faces
+		// on the edge, or the collapse would pinch the surface
+		int countedMark = ++mark;
+		int commonCount = 0;
+
+		for (int c = to; c != -1; c = chainNext[c])
+		{
+			for (int i = adjacencyStarts[c]; i < adjacencyStarts[c + 1]; ++i)
+			{
+				int face = adjacency[i];
+
+				if (!alive[face])
+					continue;
+
+				for (int j = 0; j < 3; ++j)
+				{
+					int other = indices[face * 3 + j];
+
+					if (other != from && other != to && marks[other] == neighbourMark)
+					{
+						marks[other] = countedMark;
+						++commonCount;
+					}
+				}
+			}
+		}
+
+		if (commonCount != sharedFaceCount)
+			return false;
+
+		// None of the faces that move may flip over
+		for (int c = from; c != -1; c = chainNext[c])
+		{
+			for (int i = adjacencyStarts[c]; i < adjacencyStarts[c + 1]; ++i)
+			{
+				int face = adjacency[i];
+
+				if (!alive[face])
+					continue;
+
+				const int* corners = &indices[face * 3];
+
+				if (corners[0] == to || corners[1] == to || corners[2] == to)
+					continue;
+
+				const Vector3* positions[3];
+				const Vector3* moved[3];
+
+				for (int j = 0; j < 3; ++j)
+				{
+					positions[j] = &mesh->vertices[corners[j]];
+					moved[j] = corners[j] == from ? &mesh->vertices[to] : positions[j];
+				}
+
+				Vector3 before, after;
+				faceNormal(positions[0], positions[1], positions[2], &before);
+				faceNormal(moved[0], moved[1], moved[2], &after);
+
+				if (dot3(&before, &after) <= 0)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	void Decimator::reserve(int vertexCount, int faceCount)
+	{
+		if (vertexCount > vertexCapacity)
+		{
+			delete[] adjacencyStarts;
+			delete[] chainNext;
+			delete[] chainTail;
+			delete[] quadrics;
+			delete[] quadricReady;
+			delete[] removed;
+			delete[] inRegion;
+			delete[] versions;
+			delete[] marks;
+
+			vertexCapacity = vertexCount > vertexCapacity * 3 / 2 ? vertexCount : vertexCapacity * 3 / 2;
+
+			adjacencyStarts = new int[vertexCapacity + 1];
+			chainNext = new int[vertexCapacity];
+			chainTail = new int[vertexCapacity];
+			quadrics = new double[vertexCapacity * QUADRIC_SIZE];
+			quadricReady = new bool[vertexCapacity];
+			removed = new bool[vertexCapacity];
+			inRegion = new bool[vertexCapacity];
+			versions = new int[vertexCapacity];
+			marks = new int[vertexCapacity];
+		}
+
+		if (faceCount > faceCapacity)
+		{
+			delete[] adjacency;
+			delete[] alive;
+
+			faceCapacity = faceCount > faceCapacity * 3 / 2 ? faceCount : faceCapacity * 3 / 2;
+
+			adjacency = new int[faceCapacity * 3];
+			alive = new bool[faceCapacity];
+		}
+	}
+}
@@ -0,0 +1,356 @@
+#include "meshes/Mesh.h"
+#include "meshes/MeshBvh.h"
+#include "meshes/TriangleSplit.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace cut
+{
+	namespace
+	{
+		unsigned long long edgeKey(int a, int b)
+		{
+			if (a > b)
+				std::swap(a, b);
+
+			return ((unsigned long long)a << 32) | (unsigned int)b;
+		}
+
+		// A crossed edge of the faces being split. Where the slit runs through the edge it gets a
+		// vertex for each side, and where the slit ends on it both sides share one.
+		struct KnifeEdge
+		{
+			int a, b;
+			int faceCount;
+			int leftVertex;
+			int rightVertex;
+		};
+
+		struct KnifeFace
+		{
+			int face;
+			TriangleSplit split;
+		};
+
+		// Adds the point where the edge crosses the plane, interpolating from the lower index
+		int addEdgeVertex(Mesh* mesh, const KnifeEdge* edge, const float* distances)
+		{
+			int index = mesh->vertexCount++;
+			float t = distances[0] / (distances[0] - distances[1]);
+
+			lerp3(&mesh->vertices[edge->a], &mesh->vertices[edge->b], t, &mesh->vertices[index]);
+
+			if (mesh->vertexNormals != nullptr)
+				lerp3(&mesh->vertexNormals[edge->a], &mesh->vertexNormals[edge->b], t, &mesh->vertexNormals[index]);
+
+			if (mesh->texCoords != nullptr)
+			{
+				const Vector2* from = &mesh->texCoords[edge->a];
+				const Vector2* to = &mesh->texCoords[edge->b];
+
+				mesh->texCoords[index].x = from->x + (to->x - from->x) * t;
+				mesh->texCoords[index].y = from->y + (to->y - from->y) * t;
+			}
+
+			return index;
+		}
+
+		// Writes a triangle over face, or as a new piece of it once face has been used
+		void emitPiece(Mesh* mesh, MeshBvh* bvh, int face, bool* faceUsed, int a, int b, int c)
+		{
+			int target = face;
+
+			if (*faceUsed)
+			{
+				target = mesh->indexCount / 3;
+				mesh->indexCount += 3;
+
+				bvh->addPiece(face, target);
+			}
+
+			*faceUsed = true;
+
+			mesh->indices[target * 3 + 0] = a;
+			mesh->indices[target * 3 + 1] = b;
+			mesh->indices[target * 3 + 2] = c;
+		}
+
+		// Splits a face at the points where the slit ends on its edges, without separating it
+		void splitAtEdgePoints(Mesh* mesh, MeshBvh* bvh, int face, bool* faceUsed, int a, int b, int c, const std::unordered_map<unsigned long long, int>& endPoints)
+		{
+			int corners[3] = { a, b, c };
+
+			for (int i = 0; i < 3; ++i)
+			{
+				std::unordered_map<unsigned long long, int>::const_iterator point = endPoints.find(edgeKey(corners[i], corners[(i + 1) % 3]));
+
+				if (point == endPoints.end())
+					continue;
+
+				int x = point->second;
+				int next = corners[(i + 1) % 3];
+				int opposite = corners[(i + 2) % 3];
+
+				splitAtEdgePoints(mesh, bvh, face, faceUsed, corners[i], x, opposite, endPoints);
+				splitAtEdgePoints(mesh, bvh, face, faceUsed, x, next, opposite, endPoints);
+				return;
+			}
+
+			emitPiece(mesh, bvh, face, faceUsed, a, b, c);
+		}
+	}
+
+	int Mesh::knifeCut(MeshBvh* bvh, Vector3 segmentStart, Vector3 segmentEnd, Vector3 sweep, const CutOptions& options)
+	{
+		Vector3 along, planeNormal;
+		sub3(&segmentEnd, &segmentStart, &along);
+		cross3(&along, &sweep, &planeNormal);
+
+		if (length3(&planeNormal) <= 0)
+			return 0;
+
+		normalise3(&planeNormal, &planeNormal);
+
+		// Only faces near the quad the stroke sweeps out can be split
+		Vector3 corners[4] = { segmentStart, segmentEnd, segmentStart, segmentEnd };
+		add3(&corners[2], &sweep, &corners[2]);
+		add3(&corners[3], &sweep, &corners[3]);
+
+		Vector3 boxMin = corners[0], boxMax = corners[0];
+
+		for (int i = 1; i < 4; ++i)
+		{
+			boxMin.x = std::min(boxMin.x, corners[i].x);
+			boxMin.y = std::min(boxMin.y, corners[i].y);
+			boxMin.z = std::min(boxMin.z, corners[i].z);
+			boxMax.x = std::max(boxMax.x, corners[i].x);
+			boxMax.y = std::max(boxMax.y, corners[i].y);
+			boxMax.z = std::max(boxMax.z, corners[i].z);
+		}
+
+		Vector3 margin = { options.epsilon, options.epsilon, options.epsilon };
+		sub3(&boxMin, &margin, &boxMin);
+		add3(&boxMax, &margin, &boxMax);
+
+		std::vector<int> candidates;
+		bvh->query(&boxMin, &boxMax, &candidates);
+
+		// For working out where on the quad a point is
+		float alongLength = dot3(&along, &along);
+		float sweepLength = dot3(&sweep, &sweep);
+		float alongSweep = dot3(&along, &sweep);
+		float determinant = alongLength * sweepLength - alongSweep * alongSweep;
+
+		// Split the faces the stroke crosses within the quad
+		std::vector<KnifeFace> knifeFaces;
+		std::unordered_set<int> knifeFaceSet;
+
+		for (size_t i = 0; i < candidates.size(); ++i)
+		{
+			const int* face = &indices[candidates[i] * 3];
+
+			float distances[3];
+			PlaneSide sides[3];
+
+			for (int j = 0; j < 3; ++j)
+			{
+				Vector3 offset;
+				sub3(&vertices[face[j]], &segmentStart, &offset);
+
+				distances[j] = dot3(&offset, &planeNormal);
+				sides[j] = classifyDistance(distances[j], options.epsilon);
+			}
+
+			KnifeFace knifeFace;
+			knifeFace.face = candidates[i];
+			splitTriangle(sides, &knifeFace.split);
+
+			if (knifeFace.split.triangleCount == 1)
+				continue;
+
+			// The face is split if the middle of its cut line is on the quad
+			Vector3 middle = { 0.0f, 0.0f, 0.0f };
+			int pointCount = 0;
+
+			for (int j = 0; j < 3; ++j)
+			{
+				Vector3 point;
+
+				if (sides[j] == SIDE_ON)
+					point = vertices[face[j]];
+				else if (sides[(j + 1) % 3] != SIDE_ON && sides[j] != sides[(j + 1) % 3])
+					lerp3(&vertices[face[j]], &vertices[face[(j + 1) % 3]], distances[j] / (distances[j] - distances[(j + 1) % 3]), &point);
+				else
+					continue;
+
+				add3(&middle, &point, &middle);
+				++pointCount;
+			}
+
+			Vector3 offset = { middle.x / pointCount, middle.y / pointCount, middle.z / pointCount };
+			sub3(&offset, &segmentStart, &offset);
+
+			float offsetAlong = dot3(&offset, &along);
+			float offsetSweep = dot3(&offset, &sweep);
+
+			float u = (offsetAlong * sweepLength - offsetSweep * alongSweep) / determinant;
+			float v = (offsetSweep * alongLength - offsetAlong * alongSweep) / determinant;
+
+			if (u < 0.0f || u > 1.0f || v < 0.0f || v > 1.0f)
+				continue;
+
+			knifeFaces.push_back(knifeFace);
+			knifeFaceSet.insert(knifeFace.face);
+		}
+
+		if (knifeFaces.empty())
+			return 0;
+
+		clearAdjacency();
+		markChanged();
+
+		// Count how many split faces share each crossed edge
+		std::unordered_map<unsigned long long, KnifeEdge> edges;
+
+		for (size_t i = 0; i < knifeFaces.size(); ++i)
+		{
+			const int* face = &indices[knifeFaces[i].face * 3];
+			const TriangleSplit* split = &knifeFaces[i].split;
+
+			for (int j = 0; j < 3; ++j)
+			{
+				int a = face[j];
+				int b = face[(j + 1) % 3];
+
+				bool crossed = false;
+
+				for (int k = 0; k < split->triangleCount * 3; ++k)
+					crossed = crossed || split->corners[k / 3][k % 3] == SPLIT_EDGE + j;
+
+				if (!crossed)
+					continue;
+
+				KnifeEdge& edge = edges[edgeKey(a, b)];
+
+				if (edge.faceCount == 0)
+				{
+					edge.a = std::min(a, b);
+					edge.b = std::max(a, b);
+					edge.leftVertex = edge.rightVertex = -1;
+				}
+
+				++edge.faceCount;
+			}
+		}
+
+		// Worst case: two vertices per edge, three pieces per split face and four per neighbour
+		reserve(vertexCount + (int)edges.size() * 2, indexCount + ((int)knifeFaces.size() * 2 + (int)edges.size() * 3) * 3);
+
+		// Give each edge its vertices, finding the uncut neighbours of edges where the slit ends
+		std::unordered_map<unsigned long long, int> endPoints;
+		std::vector<int> neighbours;
+		std::vector<int> edgeFaces;
+
+		for (std::unordered_map<unsigned long long, KnifeEdge>::iterator i = edges.begin(); i != edges.end(); ++i)
+		{
+			KnifeEdge* edge = &i->second;
+
+			Vector3 offset;
+			float distances[2];
+
+			sub3(&vertices[edge->a], &segmentStart, &offset);
+			distances[0] = dot3(&offset, &planeNormal);
+			sub3(&vertices[edge->b], &segmentStart, &offset);
+			distances[1] = dot3(&offset, &planeNormal);
+
+			int neighbour = -1;
+
+			if (edge->faceCount == 1)
+			{
+				Vector3 edgeMin = vertices[edge->a], edgeMax = vertices[edge->a];
+
+				edgeMin.x = std::min(edgeMin.x, vertices[edge->b].x);
+				edgeMin.y = std::min(edgeMin.y, vertices[edge->b].y);
+				edgeMin.z = std::min(edgeMin.z, vertices[edge->b].z);
+				edgeMax.x = std::max(edgeMax.x, vertices[edge->b].x);
+				edgeMax.y = std::max(edgeMax.y, vertices[edge->b].y);
+				edgeMax.z = std::max(edgeMax.z, vertices[edge->b].z);
+
+				edgeFaces.clear();
+				bvh->query(&edgeMin, &edgeMax, &edgeFaces);
+
+				for (size_t j = 0; j < edgeFaces.size() && neighbour == -1; ++j)
+				{
+					const int* face = &indices[edgeFaces[j] * 3];
+
+					bool hasA = face[0] == edge->a || face[1] == edge->a || face[2] == edge->a;
+					bool hasB = face[0] == edge->b || face[1] == edge->b || face[2] == edge->b;
+
+					if (hasA && hasB && knifeFaceSet.count(edgeFaces[j]) == 0)
+						neighbour = edgeFaces[j];
+				}
+			}
+
+			edge->leftVertex = addEdgeVertex(this, edge, distances);
+
+			// The slit ends here, so both sides share the point and the neighbour is split through it
+			if (neighbour != -1)
+			{
+				edge->rightVertex = edge->leftVertex;
+
+				endPoints[i->first] = edge->leftVertex;
+				neighbours.push_back(neighbour);
+			}
+			else
+				edge->rightVertex = addEdgeVertex(this, edge, distances);
+		}
+
+		// Split the faces the stroke cut, giving each side its own copy of the edge points
+		for (size_t i = 0; i < knifeFaces.size(); ++i)
+		{
+			int face[3] = { indices[knifeFaces[i].face * 3], indices[knifeFaces[i].face * 3 + 1], indices[knifeFaces[i].face * 3 + 2] };
+			const TriangleSplit* split = &knifeFaces[i].split;
+
+			bool faceUsed = false;
+
+			for (int j = 0; j < split->triangleCount; ++j)
+			{
+				int piece[3];
+
+				for (int k = 0; k < 3; ++k)
+				{
+					int corner = split->corners[j][k];
+
+					if (corner < SPLIT_EDGE)
+					{
+						piece[k] = face[corner];
+						continue;
+					}
+
+					const KnifeEdge* edge = &edges[edgeKey(face[corner - SPLIT_EDGE], face[(corner - SPLIT_EDGE + 1) % 3])];
+
+					piece[k] = split->sides[j] == SIDE_LEFT ? edge->leftVertex : edge->rightVertex;
+				}
+
+				emitPiece(this, bvh, knifeFaces[i].face, &faceUsed, piece[0], piece[1], piece[2]);
+			}
+		}
+
+		// Split the neighbours at the ends of the slit so there are no T-junctions
+		std::sort(neighbours.begin(), neighbours.end());
+		neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+
+		for (size_t i = 0; i < neighbours.size(); ++i)
+		{
+			int* face = &indices[neighbours[i] * 3];
+			bool faceUsed = false;
+
+			splitAtEdgePoints(this, bvh, neighbours[i], &faceUsed, face[0], face[1], face[2], endPoints);
+		}
+
+		return (int)knifeFaces.size();
+	}
+}
@@ -0,0 +1,79 @@
+#include "meshes/MassProperties.h"
+
+namespace cut
+{
+	MassAccumulator::MassAccumulator(Vector3 origin)
+		: origin(origin), volume(0)
+	{
+		for (int i = 0; i < 3; ++i)
+			moments[i] = 0;
+
+		for (int i = 0; i < 6; ++i)
+			products[i] = 0;
+	}
+
+	void MassAccumulator::addTriangle(const Vector3* a, const Vector3* b, const Vector3* c)
+	{
+		double ax = a->x - origin.x, ay = a->y - origin.y, az = a->z - origin.z;
+		double bx = b->x - origin.x, by = b->y - origin.y, bz = b->z - origin.z;
+		double cx = c->x - origin.x, cy = c->y - origin.y, cz = c->z - origin.z;
+
+		// Six times the signed volume of the tetrahedron from the origin. Faces are wound with
+		// their outward normal along (c - a) x (b - a), so this is positive for an outward face.
+		double det = ax * (bz * cy - by * cz) + ay * (bx * cz - bz * cx) + az * (by * cx - bx * cy);
+
+		double sx = ax + bx + cx, sy = ay + by + cy, sz = az + bz + cz;
+
+		volume += det;
+
+		moments[0] += det * sx;
+		moments[1] += det * sy;
+		moments[2] += det * sz;
+
+		// The second moments of a tetrahedron with a corner at the origin are
+		// det / 120 * (aa' + bb' + cc' + ss') where s is the sum of the other corners
+		products[0] += det * (ax * ax + bx * bx + cx * cx + sx * sx);
+		products[1] += det * (ay * ay + by * by + cy * cy + sy * sy);
+		products[2] += det * (az * az + bz * bz + cz * cz + sz * sz);
+		products[3] += det * (ax * ay + bx * by + cx * cy + sx * sy);
+		products[4] += det * (ay * az + by * bz + cy * cz + sy * sz);
+		products[5] += det * (az * ax + bz * bx + cz * cx + sz * sx);
+	}
+
+	void MassAccumulator::getProperties(MassProperties* result) const
+	{
+		double mass = volume / 6;
+
+		double centre[3] = { 0, 0, 0 };
+
+		if (mass != 0)
+		{
+			for (int i = 0; i < 3; ++i)
+				centre[i] = moments[i] / 24 / mass;
+		}
+
+		// Move the second moments to the centre of mass
+		double xx = products[0] / 120 - mass * centre[0] * centre[0];
+		double yy = products[1] / 120 - mass * centre[1] * centre[1];
+		double zz = products[2] / 120 - mass * centre[2] * centre[2];
+		double xy = products[3] / 120 - mass * centre[0] * centre[1];
+		double yz = products[4] / 120 - mass * centre[1] * centre[2];
+		double zx = products[5] / 120 - mass * centre[2] * centre[0];
+
+		result->volume = (float)mass;
+
+		result->centreOfMass.x = (float)(origin.x + centre[0]);
+		result->centreOfMass.y = (float)(origin.y + centre[1]);
+		result->centreOfMass.z = (float)(origin.z + centre[2]);
+
+		result->inertia.data[0] = (float)(yy + zz);
+		result->inertia.data[1] = (float)-xy;
+		result->inertia.data[2] = (float)-zx;
+		result->inertia.data[3] = (float)-xy;
+		result->inertia.data[4] = (float)(xx + zz);
+		result->inertia.data[5] = (float)-yz;
+		result->inertia.data[6] = (float)-zx;
+		result->inertia.data[7] = (float)-yz;
+		result->inertia.data[8] = (float)(xx + yy);
+	}
+}
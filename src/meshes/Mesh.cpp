@@ -1,31 +1,33 @@
 #include "meshes/Mesh.h"
 
+#include "maths/VectorBatch.h"
+#include "memory/MemoryResource.h"
+#include "meshes/ConvexHull.h"
+#include "meshes/CutPlan.h"
+#include "meshes/Decimator.h"
+#include "meshes/MassProperties.h"
+#include "meshes/MeshLoader.h"
+#include "meshes/TriangleSplit.h"
+#include "meshes/VertexCacheOptimiser.h"
+
 #include <stdio.h>
-#include <string>
-#include <fstream>
+#include <string.h>
+#include <unordered_map>
+
+// The bounds checked version is only in the Microsoft runtime, and none of the formats here
+// write strings, so the standard one is the same elsewhere
+#ifndef _MSC_VER
+#define sscanf_s sscanf
+#endif
 
 namespace cut
 {
-	Mesh::Mesh()
-		: vertexCount(0), indexCount(0), vertices(nullptr), indices(nullptr), vertexNormals(nullptr), texCoords(nullptr)
-	{
-
-	}
-
-	Mesh::~Mesh()
+	namespace
 	{
-		delete[] vertices;
-		delete[] indices;
-		delete[] vertexNormals;
-		delete[] texCoords;
-	}
-
-	void Mesh::createCube()
-	{
-		const int VERTEX_COUNT = 8;
-		const int INDEX_COUNT = 36;
+		const int CUBE_VERTEX_COUNT = 8;
+		const int CUBE_INDEX_COUNT = 36;
 
-		static Vector3 VERTICES[VERTEX_COUNT] =
+		Vector3 CUBE_VERTICES[CUBE_VERTEX_COUNT] =
 		{
 			{  1.0f, -1.0f, -1.0f },
 			{  1.0f, -1.0f,  1.0f },
@@ -37,7 +39,7 @@ namespace cut
 			{ -1.0f,  1.0f, -1.0f }
 		};
 
-		static Vector3 NORMALS[VERTEX_COUNT] =
+		Vector3 CUBE_NORMALS[CUBE_VERTEX_COUNT] =
 		{
 			{  0.666667f, -0.666667f, -0.333333f },
 			{  0.408248f, -0.408248f,  0.816497f },
@@ -49,7 +51,7 @@ namespace cut
 			{ -0.816497f,  0.408248f, -0.408248f }
 		};
 
-		static int INDICES[INDEX_COUNT] =
+		int CUBE_INDICES[CUBE_INDEX_COUNT] =
 		{
 			1, 0, 2, 2, 0, 3,
 			7, 4, 6, 6, 4, 5,
@@ -59,7 +61,7 @@ namespace cut
 			0, 4, 3, 3, 4, 7
 		};
 
-		static Vector2 UVS[VERTEX_COUNT] =
+		Vector2 UVS[CUBE_VERTEX_COUNT] =
 		{
 			{ 0.0f, 0.0f },
 			{ 0.0f, 0.0f },
@@ -70,26 +72,537 @@ namespace cut
 			{ 0.0f, 0.0f },
 			{ 0.0f, 0.0f }
 		};
-		
-		vertices = new Vector3[VERTEX_COUNT];
-		memcpy(vertices, VERTICES, VERTEX_COUNT * sizeof(Vector3));
 
-		vertexNormals = new Vector3[VERTEX_COUNT];
-		memcpy(vertexNormals, NORMALS, VERTEX_COUNT * sizeof(Vector3));
+		// Reallocates an array with room for capacity elements, keeping the first count
+		template <typename T>
+		void growArray(MemoryResource* resource, T** array, int count, int capacity, bool allocateIfMissing)
+		{
+			if (*array == nullptr && !allocateIfMissing)
+				return;
+
+			T* grown = allocateArray<T>(resource, capacity);
+
+			if (*array != nullptr)
+				memcpy(grown, *array, count * sizeof(T));
+
+			freeArray(resource, *array);
+			*array = grown;
+		}
+
+		// Cut output records where each source edge went as an output corner shifted up a bit,
+		// with the half in the low bit. Parts of the same edge in the same half are opposites.
+		// Parts of a half that isn't being built are SKIPPED_PART, and never pair up.
+		const int PART_LEFT = 0;
+		const int PART_RIGHT = 1;
+		const int SKIPPED_PART = -2;
+
+		void pairEdgeParts(int first, int second, int* leftOpposites, int* rightOpposites)
+		{
+			if (first < 0 || second < 0 || (first & 1) != (second & 1))
+				return;
+
+			int* opposites = (first & 1) == PART_LEFT ? leftOpposites : rightOpposites;
+
+			opposites[first >> 1] = second >> 1;
+			opposites[second >> 1] = first >> 1;
+		}
+
+		// Whole faces only need their first output corner, and split faces keep the part (or
+		// the two parts either side of the intersection) for each of their edges
+		void getEdgeParts(int corner, const int* faceParts, const int* edgeParts, int* first, int* second)
+		{
+			int faceOutput = faceParts[corner / 3];
+
+			if (faceOutput == SKIPPED_PART)
+			{
+				*first = SKIPPED_PART;
+				*second = -1;
+			}
+			else if (faceOutput != -1)
+			{
+				*first = faceOutput + ((corner % 3) << 1);
+				*second = -1;
+			}
+			else
+			{
+				*first = edgeParts[(size_t)corner * 2];
+				*second = edgeParts[(size_t)corner * 2 + 1];
+			}
+		}
+
+		// Xorshift, so generated meshes are the same on every platform
+		float randomFloat(unsigned int* state)
+		{
+			*state ^= *state << 13;
+			*state ^= *state >> 17;
+			*state ^= *state << 5;
+
+			return (*state >> 8) * (1.0f / 16777216.0f);
+		}
+	}
+
+	Mesh::Mesh(MemoryResource* resource)
+		: vertices(nullptr), indices(nullptr), vertexNormals(nullptr), texCoords(nullptr), vertexCount(0), indexCount(0), vertexCapacity(0), indexCapacity(0), opposites(nullptr),
+		  resource(resource != nullptr ? resource : MemoryResource::getDefault()), version(0)
+	{
+
+	}
+
+	Mesh::~Mesh()
+	{
+		release();
+	}
+
+	void Mesh::release()
+	{
+		freeArray(resource, vertices);
+		freeArray(resource, indices);
+		freeArray(resource, vertexNormals);
+		freeArray(resource, texCoords);
+		freeArray(resource, opposites);
+
+		vertices = nullptr;
+		indices = nullptr;
+		vertexNormals = nullptr;
+		texCoords = nullptr;
+		opposites = nullptr;
+
+		vertexCount = 0;
+		indexCount = 0;
+		vertexCapacity = 0;
+		indexCapacity = 0;
+
+		version++;
+	}
+
+	void Mesh::setMemoryResource(MemoryResource* resource)
+	{
+		release();
+
+		this->resource = resource != nullptr ? resource : MemoryResource::getDefault();
+	}
+
+	void Mesh::reserve(int newVertexCount, int newIndexCount)
+	{
+		// Grow geometrically so repeated small additions stay cheap
+		if (newVertexCount > vertexCapacity)
+		{
+			int capacity = newVertexCount > vertexCapacity * 3 / 2 ? newVertexCount : vertexCapacity * 3 / 2;
+
+			growArray(resource, &vertices, vertexCount, capacity, true);
+			growArray(resource, &vertexNormals, vertexCount, capacity, false);
+			growArray(resource, &texCoords, vertexCount, capacity, false);
+
+			vertexCapacity = capacity;
+		}
 
-		indices = new int[INDEX_COUNT];
-		memcpy(indices, INDICES, INDEX_COUNT * sizeof(int));
+		if (newIndexCount > indexCapacity)
+		{
+			int capacity = newIndexCount > indexCapacity * 3 / 2 ? newIndexCount : indexCapacity * 3 / 2;
+
+			growArray(resource, &indices, indexCount, capacity, true);
+
+			indexCapacity = capacity;
+		}
+	}
+
+	void Mesh::copyTo(Mesh* result) const
+	{
+		if (result == this)
+			return;
+
+		result->release();
+
+		MemoryResource* resultResource = result->resource;
+
+		result->vertices = allocateArray<Vector3>(resultResource, vertexCount);
+		result->vertexNormals = vertexNormals != nullptr ? allocateArray<Vector3>(resultResource, vertexCount) : nullptr;
+		result->texCoords = texCoords != nullptr ? allocateArray<Vector2>(resultResource, vertexCount) : nullptr;
+		result->indices = allocateArray<int>(resultResource, indexCount);
+		result->opposites = opposites != nullptr ? allocateArray<int>(resultResource, indexCount) : nullptr;
+
+		memcpy(result->vertices, vertices, vertexCount * sizeof(Vector3));
+		memcpy(result->indices, indices, indexCount * sizeof(int));
+
+		if (vertexNormals != nullptr)
+			memcpy(result->vertexNormals, vertexNormals, vertexCount * sizeof(Vector3));
+
+		if (texCoords != nullptr)
+			memcpy(result->texCoords, texCoords, vertexCount * sizeof(Vector2));
+
+		if (opposites != nullptr)
+			memcpy(result->opposites, opposites, indexCount * sizeof(int));
+
+		result->vertexCount = vertexCount;
+		result->indexCount = indexCount;
+		result->vertexCapacity = vertexCount;
+		result->indexCapacity = indexCount;
+	}
+
+	void Mesh::createCube()
+	{
+		release();
 
-		texCoords = new Vector2[VERTEX_COUNT];
-		memcpy(UVS, texCoords, VERTEX_COUNT * sizeof(Vector2));
+		vertices = allocateArray<Vector3>(resource, CUBE_VERTEX_COUNT);
+		memcpy(vertices, CUBE_VERTICES, CUBE_VERTEX_COUNT * sizeof(Vector3));
+
+		vertexNormals = allocateArray<Vector3>(resource, CUBE_VERTEX_COUNT);
+		memcpy(vertexNormals, CUBE_NORMALS, CUBE_VERTEX_COUNT * sizeof(Vector3));
+
+		indices = allocateArray<int>(resource, CUBE_INDEX_COUNT);
+		memcpy(indices, CUBE_INDICES, CUBE_INDEX_COUNT * sizeof(int));
+
+		texCoords = allocateArray<Vector2>(resource, CUBE_VERTEX_COUNT);
+		memcpy(texCoords, UVS, CUBE_VERTEX_COUNT * sizeof(Vector2));
+
+		vertexCount = CUBE_VERTEX_COUNT;
+		indexCount = CUBE_INDEX_COUNT;
+		vertexCapacity = vertexCount;
+		indexCapacity = indexCount;
+	}
+
+	void Mesh::createIcosphere(int frequency)
+	{
+		release();
+
+		// Each of the 20 icosahedron faces is divided into frequency^2 triangles, with the
+		// vertices on shared edges and corners stored once so the sphere stays closed
+		const float t = 1.618034f;
+
+		static Vector3 CORNERS[12] =
+		{
+			{ -1.0f,  t,  0.0f }, {  1.0f,  t,  0.0f }, { -1.0f, -t,  0.0f }, {  1.0f, -t,  0.0f },
+			{  0.0f, -1.0f,  t }, {  0.0f,  1.0f,  t }, {  0.0f, -1.0f, -t }, {  0.0f,  1.0f, -t },
+			{  t,  0.0f, -1.0f }, {  t,  0.0f,  1.0f }, { -t,  0.0f, -1.0f }, { -t,  0.0f,  1.0f }
+		};
+
+		static int FACES[20][3] =
+		{
+			{ 0, 5, 11 }, { 0, 1, 5 }, { 0, 7, 1 }, { 0, 10, 7 }, { 0, 11, 10 },
+			{ 1, 9, 5 }, { 5, 4, 11 }, { 11, 2, 10 }, { 10, 6, 7 }, { 7, 8, 1 },
+			{ 3, 4, 9 }, { 3, 2, 4 }, { 3, 6, 2 }, { 3, 8, 6 }, { 3, 9, 8 },
+			{ 4, 5, 9 }, { 2, 11, 4 }, { 6, 10, 2 }, { 8, 7, 6 }, { 9, 1, 8 }
+		};
+
+		if (frequency < 1)
+			frequency = 1;
+
+		// Find the 30 unique edges
+		int edges[30][2];
+		int faceEdges[20][3];
+		int edgeCount = 0;
+
+		for (int face = 0; face < 20; ++face)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				int u = FACES[face][k];
+				int v = FACES[face][(k + 1) % 3];
+
+				int edge = 0;
+				while (edge < edgeCount && !((edges[edge][0] == u && edges[edge][1] == v) || (edges[edge][0] == v && edges[edge][1] == u)))
+					edge++;
+
+				if (edge == edgeCount)
+				{
+					edges[edgeCount][0] = u;
+					edges[edgeCount][1] = v;
+					edgeCount++;
+				}
+
+				faceEdges[face][k] = edge;
+			}
+		}
 
-		vertexCount = VERTEX_COUNT;
-		indexCount = INDEX_COUNT;
+		int edgeVertices = frequency - 1;
+		int faceVertices = (frequency - 1) * (frequency - 2) / 2;
+		int edgeBase = 12;
+		int faceBase = edgeBase + 30 * edgeVertices;
+
+		vertexCount = faceBase + 20 * faceVertices;
+		indexCount = 20 * frequency * frequency * 3;
+		vertexCapacity = vertexCount;
+		indexCapacity = indexCount;
+
+		vertices = allocateArray<Vector3>(resource, vertexCount);
+		vertexNormals = allocateArray<Vector3>(resource, vertexCount);
+		indices = allocateArray<int>(resource, indexCount);
+
+		// Corners
+		for (int i = 0; i < 12; ++i)
+			vertices[i] = CORNERS[i];
+
+		// Points along each edge
+		for (int edge = 0; edge < 30; ++edge)
+		{
+			for (int step = 1; step < frequency; ++step)
+			{
+				lerp3(&CORNERS[edges[edge][0]], &CORNERS[edges[edge][1]], (float)step / frequency, &vertices[edgeBase + edge * edgeVertices + step - 1]);
+			}
+		}
+
+		int indicesWritten = 0;
+		int* lattice = new int[(frequency + 1) * (frequency + 1)];
+
+		for (int face = 0; face < 20; ++face)
+		{
+			int a = FACES[face][0];
+			int b = FACES[face][1];
+			int c = FACES[face][2];
+
+			Vector3 ab, ac;
+			sub3(&CORNERS[b], &CORNERS[a], &ab);
+			sub3(&CORNERS[c], &CORNERS[a], &ac);
+
+			int interior = faceBase + face * faceVertices;
+
+			// Resolve the vertex index of every lattice point (i along ab, j along ac) on this face
+			for (int i = 0; i <= frequency; ++i)
+			{
+				for (int j = 0; j <= frequency - i; ++j)
+				{
+					int index = -1;
+
+					// Pick the edge and the step along it from its first endpoint, if the point is on one
+					int edge = -1, from = 0, step = 0;
+
+					if (i == 0 && j == 0)
+						index = a;
+					else if (i == frequency)
+						index = b;
+					else if (j == frequency)
+						index = c;
+					else if (j == 0)
+					{
+						edge = faceEdges[face][0];
+						from = a;
+						step = i;
+					}
+					else if (i + j == frequency)
+					{
+						edge = faceEdges[face][1];
+						from = b;
+						step = j;
+					}
+					else if (i == 0)
+					{
+						edge = faceEdges[face][2];
+						from = a;
+						step = j;
+					}
+					else
+					{
+						Vector3 point = CORNERS[a];
+						point.x += (ab.x * i + ac.x * j) / frequency;
+						point.y += (ab.y * i + ac.y * j) / frequency;
+						point.z += (ab.z * i + ac.z * j) / frequency;
+
+						index = interior++;
+						vertices[index] = point;
+					}
+
+					if (edge >= 0)
+					{
+						if (edges[edge][0] != from)
+							step = frequency - step;
+
+						index = edgeBase + edge * edgeVertices + step - 1;
+					}
+
+					lattice[i * (frequency + 1) + j] = index;
+				}
+			}
+
+			// Triangulate the lattice, keeping the winding of the original face
+			for (int i = 0; i < frequency; ++i)
+			{
+				for (int j = 0; j < frequency - i; ++j)
+				{
+					indices[indicesWritten++] = lattice[i * (frequency + 1) + j];
+					indices[indicesWritten++] = lattice[(i + 1) * (frequency + 1) + j];
+					indices[indicesWritten++] = lattice[i * (frequency + 1) + j + 1];
+
+					if (i + j < frequency - 1)
+					{
+						indices[indicesWritten++] = lattice[(i + 1) * (frequency + 1) + j];
+						indices[indicesWritten++] = lattice[(i + 1) * (frequency + 1) + j + 1];
+						indices[indicesWritten++] = lattice[i * (frequency + 1) + j + 1];
+					}
+				}
+			}
+		}
+
+		delete[] lattice;
+
+		// Project onto the unit sphere, where the normal is the position
+		for (int i = 0; i < vertexCount; ++i)
+		{
+			normalise3(&vertices[i], &vertices[i]);
+			vertexNormals[i] = vertices[i];
+		}
+	}
+
+	void Mesh::createGrid(int columns, int rows)
+	{
+		release();
+
+		if (columns < 1)
+			columns = 1;
+		if (rows < 1)
+			rows = 1;
+
+		vertexCount = (columns + 1) * (rows + 1);
+		indexCount = columns * rows * 6;
+		vertexCapacity = vertexCount;
+		indexCapacity = indexCount;
+
+		vertices = allocateArray<Vector3>(resource, vertexCount);
+		vertexNormals = allocateArray<Vector3>(resource, vertexCount);
+		texCoords = allocateArray<Vector2>(resource, vertexCount);
+		indices = allocateArray<int>(resource, indexCount);
+
+		// Unit square in the xz plane, facing up
+		for (int z = 0; z <= rows; ++z)
+		{
+			for (int x = 0; x <= columns; ++x)
+			{
+				int i = z * (columns + 1) + x;
+
+				texCoords[i].x = (float)x / columns;
+				texCoords[i].y = (float)z / rows;
+
+				vertices[i].x = texCoords[i].x * 2.0f - 1.0f;
+				vertices[i].y = 0.0f;
+				vertices[i].z = texCoords[i].y * 2.0f - 1.0f;
+
+				vertexNormals[i].x = 0.0f;
+				vertexNormals[i].y = 1.0f;
+				vertexNormals[i].z = 0.0f;
+			}
+		}
+
+		int indicesWritten = 0;
+
+		for (int z = 0; z < rows; ++z)
+		{
+			for (int x = 0; x < columns; ++x)
+			{
+				int i = z * (columns + 1) + x;
+
+				indices[indicesWritten++] = i;
+				indices[indicesWritten++] = i + 1;
+				indices[indicesWritten++] = i + columns + 1;
+
+				indices[indicesWritten++] = i + 1;
+				indices[indicesWritten++] = i + columns + 2;
+				indices[indicesWritten++] = i + columns + 1;
+			}
+		}
+	}
+
+	void Mesh::createTerrain(int columns, int rows, float height, unsigned int seed)
+	{
+		createGrid(columns, rows);
+
+		// Lattice of random heights for each octave of value noise
+		const int LATTICE_SIZE = 64;
+		const int OCTAVES = 6;
+
+		float* lattice = new float[LATTICE_SIZE * LATTICE_SIZE];
+		unsigned int state = seed | 1;
+
+		for (int i = 0; i < LATTICE_SIZE * LATTICE_SIZE; ++i)
+			lattice[i] = randomFloat(&state) * 2.0f - 1.0f;
+
+		for (int i = 0; i < vertexCount; ++i)
+		{
+			float frequency = 4.0f;
+			float amplitude = 0.5f;
+			float sum = 0.0f;
+
+			for (int octave = 0; octave < OCTAVES; ++octave)
+			{
+				// Bilinear interpolation of the lattice, offset per octave so octaves don't line up
+				float u = texCoords[i].x * frequency + octave * 17.0f;
+				float v = texCoords[i].y * frequency + octave * 31.0f;
+
+				int x0 = (int)u;
+				int y0 = (int)v;
+				float fx = u - x0;
+				float fy = v - y0;
+
+				fx = fx * fx * (3.0f - 2.0f * fx);
+				fy = fy * fy * (3.0f - 2.0f * fy);
+
+				float h00 = lattice[(y0 % LATTICE_SIZE) * LATTICE_SIZE + x0 % LATTICE_SIZE];
+				float h10 = lattice[(y0 % LATTICE_SIZE) * LATTICE_SIZE + (x0 + 1) % LATTICE_SIZE];
+				float h01 = lattice[((y0 + 1) % LATTICE_SIZE) * LATTICE_SIZE + x0 % LATTICE_SIZE];
+				float h11 = lattice[((y0 + 1) % LATTICE_SIZE) * LATTICE_SIZE + (x0 + 1) % LATTICE_SIZE];
+
+				float h0 = h00 + (h10 - h00) * fx;
+				float h1 = h01 + (h11 - h01) * fx;
+
+				sum += (h0 + (h1 - h0) * fy) * amplitude;
+
+				frequency *= 2.0f;
+				amplitude *= 0.5f;
+			}
+
+			vertices[i].y = sum * height;
+		}
+
+		delete[] lattice;
+
+		calculateNormals();
+	}
+
+	void Mesh::createSoup(int componentCount, unsigned int seed)
+	{
+		release();
+
+		if (componentCount < 1)
+			componentCount = 1;
+
+		vertexCount = componentCount * CUBE_VERTEX_COUNT;
+		indexCount = componentCount * CUBE_INDEX_COUNT;
+		vertexCapacity = vertexCount;
+		indexCapacity = indexCount;
+
+		vertices = allocateArray<Vector3>(resource, vertexCount);
+		vertexNormals = allocateArray<Vector3>(resource, vertexCount);
+		indices = allocateArray<int>(resource, indexCount);
+
+		unsigned int state = seed | 1;
+
+		// Small cubes scattered through the unit cube, none of which share vertices
+		for (int component = 0; component < componentCount; ++component)
+		{
+			Vector3 centre;
+			centre.x = randomFloat(&state) * 2.0f - 1.0f;
+			centre.y = randomFloat(&state) * 2.0f - 1.0f;
+			centre.z = randomFloat(&state) * 2.0f - 1.0f;
+
+			float size = 0.005f + randomFloat(&state) * 0.02f;
+
+			int firstVertex = component * CUBE_VERTEX_COUNT;
+
+			for (int i = 0; i < CUBE_VERTEX_COUNT; ++i)
+			{
+				vertices[firstVertex + i].x = centre.x + CUBE_VERTICES[i].x * size;
+				vertices[firstVertex + i].y = centre.y + CUBE_VERTICES[i].y * size;
+				vertices[firstVertex + i].z = centre.z + CUBE_VERTICES[i].z * size;
+
+				vertexNormals[firstVertex + i] = CUBE_NORMALS[i];
+			}
+
+			for (int i = 0; i < CUBE_INDEX_COUNT; ++i)
+				indices[component * CUBE_INDEX_COUNT + i] = firstVertex + CUBE_INDICES[i];
+		}
 	}
 
-	void Mesh::loadObj(const char* inputFile)
+	void Mesh::loadObj(const char* inputFile, bool spatialOrder)
 	{
-		return loadObjOld(inputFile);
+		return loadObjOld(inputFile, spatialOrder);
 
 		// Obj specific datatypes
 		union ObjVertex
@@ -264,9 +777,12 @@ namespace cut
 
 		// Convert obj model to Mesh
 		// Max number of vertices = face count * 4
-		vertices = new Vector3[objFaceCount * 4];
-		texCoords = new Vector2[objFaceCount * 4];
-		indices = new int[objFaceCount*4];
+		vertices = allocateArray<Vector3>(resource, objFaceCount * 4);
+		texCoords = allocateArray<Vector2>(resource, objFaceCount * 4);
+		indices = allocateArray<int>(resource, objFaceCount * 4);
+
+		vertexCapacity = objFaceCount * 4;
+		indexCapacity = objFaceCount * 4;
 
 		for (int i = 0; i < objFaceCount; ++i)
 		{
@@ -300,609 +816,682 @@ namespace cut
 		}
 
 		// Clean up memory
-		delete objVertices;
-		delete objFaces;
-		delete objUvs;
+		delete[] objVertices;
+		delete[] objFaces;
+		delete[] objUvs;
 	}
 
-	void Mesh::loadObjOld(const char* inputFile)
+	void Mesh::loadObjOld(const char* inputFile, bool spatialOrder)
 	{
-		std::ifstream model(inputFile);
+		release();
+
+		char* text = readTextFile(inputFile, nullptr);
 
-		if (model)
+		if (text != nullptr)
 		{
-			std::string line;
+			parseObj(text);
+
+			// Before the normals, so there's one less array to move
+			if (spatialOrder)
+				reorderSpatially();
+
+			calculateNormals();
+		}
+
+		delete[] text;
+	}
 
-			int a, b, c, d;
+	void Mesh::parseObj(char* text)
+	{
+		release();
+
+		// Split into lines in place, dropping the carriage returns of Windows line endings
+		char* end = text + strlen(text);
+
+		for (char* c = text; c < end; ++c)
+			if (*c == '\n' || (*c == '\r' && c[1] == '\n'))
+				*c = '\0';
+
+		int a, b, c, d;
 
-			// Initial pass
-			while (std::getline(model, line))
+		// Initial pass
+		for (const char* line = text; line < end; line += strlen(line) + 1)
+		{
+			if (strlen(line) > 1)
 			{
-				if (line.length() > 1)
+				switch (line[0])
 				{
-					switch (line[0])
-					{
-					case 'v':
-						if (line[1] == ' ')
-							vertexCount++;
-						break;
-					case 'f':
-						if (sscanf_s(line.c_str(), "f %d %d %d %d", &a, &b, &c, &d) == 4
-							|| sscanf_s(line.c_str(), "f %d/%*d %d/%*d %d/%*d %d/%*d", &a, &b, &c, &d) == 4
-							|| sscanf_s(line.c_str(), "f %d/%*d/%*d %d/%*d/%*d %d/%*d/%*d %d/%*d/%*d", &a, &b, &c, &d) == 4)
-							indexCount += 3;
+				case 'v':
+					if (line[1] == ' ')
+						vertexCount++;
+					break;
+				case 'f':
+					if (sscanf_s(line, "f %d %d %d %d", &a, &b, &c, &d) == 4
+						|| sscanf_s(line, "f %d/%*d %d/%*d %d/%*d %d/%*d", &a, &b, &c, &d) == 4
+						|| sscanf_s(line, "f %d/%*d/%*d %d/%*d/%*d %d/%*d/%*d %d/%*d/%*d", &a, &b, &c, &d) == 4)
 						indexCount += 3;
-						break;
-					default:
-						break;
-					}
+					indexCount += 3;
+					break;
+				default:
+					break;
 				}
 			}
+		}
 
-			// Allocate memory
-			vertices = new cut::Vector3[vertexCount];
-			indices = new int[indexCount * 3];
+		// Allocate memory
+		vertices = allocateArray<Vector3>(resource, vertexCount);
+		indices = allocateArray<int>(resource, indexCount * 3);
 
-			model.clear();
-			model.seekg(std::ios::beg);
+		vertexCapacity = vertexCount;
+		indexCapacity = indexCount * 3;
 
-			int verticesRead = 0;
-			int indicesRead = 0;
+		int verticesRead = 0;
+		int indicesRead = 0;
 
-			int matches = 0;
+		int matches = 0;
 
-			FILE* file = fopen("indices.txt", "w");
-			// Second pass - read data
-			while (std::getline(model, line))
-			{ 
-				matches = 0;
-				if (line.length() > 1)
+		// Second pass - read data
+		for (const char* line = text; line < end; line += strlen(line) + 1)
+		{
+			matches = 0;
+			if (strlen(line) > 1)
+			{
+				switch (line[0])
 				{
-					switch (line[0])
+				case 'v':
+					if (sscanf_s(line, "v %f %f %f", &vertices[verticesRead].x, &vertices[verticesRead].y, &vertices[verticesRead].z) == 3)
 					{
-					case 'v':
-						if (sscanf_s(line.c_str(), "v %f %f %f", &vertices[verticesRead].x, &vertices[verticesRead].y, &vertices[verticesRead].z) == 3)
-						{
-							verticesRead++;
-						}
-						break;
-					case 'f':
-						if ((matches = sscanf_s(line.c_str(), "f %d/%*s %d/%*s %d/%*s %d/%*s", &a, &b, &c, &d)) >= 3)
+						verticesRead++;
+					}
+					break;
+				case 'f':
+					if ((matches = sscanf_s(line, "f %d/%*s %d/%*s %d/%*s %d/%*s", &a, &b, &c, &d)) >= 3)
+					{
+						indices[indicesRead] = a - 1;
+						indices[indicesRead+1] = b - 1;
+						indices[indicesRead+2] = c - 1;
+						indicesRead += 3;
+
+						if (matches > 3)
 						{
-							indices[indicesRead] = a - 1;
-							indices[indicesRead+1] = b - 1;
-							indices[indicesRead+2] = c - 1;
+							indices[indicesRead] = d - 1;
+							indices[indicesRead+1] = c - 1;
+							indices[indicesRead+2] = a - 1;
 							indicesRead += 3;
-
-							if (matches > 3)
-							{
-								indices[indicesRead] = d - 1;
-								indices[indicesRead+1] = c - 1;
-								indices[indicesRead+2] = a - 1;
-								indicesRead += 3;
-							}
 						}
-						else if ((matches = sscanf_s(line.c_str(), "f %d/%*d %d/%*d %d/%*d %d/%*d", &a, &b, &c, &d)) >= 3)
+					}
+					else if ((matches = sscanf_s(line, "f %d/%*d %d/%*d %d/%*d %d/%*d", &a, &b, &c, &d)) >= 3)
+					{
+						indices[indicesRead] = a - 1;
+						indices[indicesRead+1] = b - 1;
+						indices[indicesRead+2] = c - 1;
+						indicesRead += 3;
+
+						if (matches > 3)
 						{
-							indices[indicesRead] = a - 1;
-							indices[indicesRead+1] = b - 1;
-							indices[indicesRead+2] = c - 1;
+							indices[indicesRead] = d - 1;
+							indices[indicesRead+1] = c - 1;
+							indices[indicesRead+2] = a - 1;
 							indicesRead += 3;
-
-							if (matches > 3)
-							{
-								indices[indicesRead] = d - 1;
-								indices[indicesRead+1] = c - 1;
-								indices[indicesRead+2] = a - 1;
-								indicesRead += 3;
-							}
 						}
-						else if ((matches = sscanf_s(line.c_str(), "f %d %d %d %d", &a, &b, &c, &d)) >= 3)
+					}
+					else if ((matches = sscanf_s(line, "f %d %d %d %d", &a, &b, &c, &d)) >= 3)
+					{
+						indices[indicesRead] = b - 1;
+						indices[indicesRead+1] = a - 1;
+						indices[indicesRead+2] = c - 1;
+						indicesRead += 3;
+
+						if (matches > 3)
 						{
-							indices[indicesRead] = b - 1;
+							indices[indicesRead] = c - 1;
 							indices[indicesRead+1] = a - 1;
-							indices[indicesRead+2] = c - 1;
+							indices[indicesRead+2] = d - 1;
 							indicesRead += 3;
-
-							if (matches > 3)
-							{
-								indices[indicesRead] = c - 1;
-								indices[indicesRead+1] = a - 1;
-								indices[indicesRead+2] = d - 1;
-								indicesRead += 3;
-
-								fprintf(file, "{ %d, %d, %d, %d, %d, %d },\n", b-1,a-1,c-1,c-1,a-1,d-1);
-							}
 						}
-						break;
-					default:
-						printf("%c", line[0]);
 					}
+					break;
+				default:
+					break;
 				}
 			}
-			fclose(file);
+		}
+	}
+
+	void Mesh::calculateNormals()
+	{
+		version++;
+
+		freeArray(resource, vertexNormals);
+
+		// Calculate normals for each face
+		Vector3* faceNormals = new Vector3[indexCount/3];
+		vertexNormals = allocateArray<Vector3>(resource, vertexCapacity > vertexCount ? vertexCapacity : vertexCount);
+		int* surroundingTriangles = new int[vertexCount];
+
+		memset(faceNormals, 0, (indexCount/3) * sizeof(Vector3));
+		memset(vertexNormals, 0, vertexCount * sizeof(Vector3));
+		memset(surroundingTriangles, 0, vertexCount * sizeof(int));
 
-			// Calculate normals for each face
-			Vector3* faceNormals = new Vector3[indexCount/3];
-			vertexNormals = new Vector3[vertexCount];
-			int* surroundingTriangles = new int[vertexCount];
+		int faceCount = indexCount/3;
 
-			memset(faceNormals, 0, (indexCount/3) * sizeof(Vector3));
-			memset(vertexNormals, 0, vertexCount * sizeof(Vector3));
-			memset(surroundingTriangles, 0, vertexCount * sizeof(int));
+		for (int i = 0; i < faceCount; ++i)
+		{
+			Vector3 edge1;
+			Vector3 edge2;
+			
+			int i1 = indices[i*3 +0];
+			int i2 = indices[i*3 +1];
+			int i3 = indices[i*3 +2];
+			
+			Vector3* v1 = &vertices[i1];
+			Vector3* v2 = &vertices[i2];
+			Vector3* v3 = &vertices[i3];
+			
+			// Calculate edges
+			sub3(v3, v1, &edge1);
+			sub3(v2, v1, &edge2);
+
+			// Calculate face normal
+			cross3(&edge1, &edge2, &faceNormals[i]);
+			normalise3(&faceNormals[i], &faceNormals[i]);
+
+			// Increment vertex normals
+			add3(&vertexNormals[i1], &faceNormals[i], &vertexNormals[i1]);
+			add3(&vertexNormals[i2], &faceNormals[i], &vertexNormals[i2]);
+			add3(&vertexNormals[i3], &faceNormals[i], &vertexNormals[i3]);
+
+			// Increment triangle count for each vertex so we can average the normals
+			surroundingTriangles[i1]++;
+			surroundingTriangles[i2]++;
+			surroundingTriangles[i3]++;
+		}
 
-			int faceCount = indexCount/3;
+		// Calculate vertex normals
+		for (int i = 0; i < vertexCount; ++i)
+		{
+			// Average normals
+			vertexNormals[i].x /= surroundingTriangles[i];
+			vertexNormals[i].y /= surroundingTriangles[i];
+			vertexNormals[i].z /= surroundingTriangles[i];
 
-			for (int i = 0; i < faceCount; ++i)
+			normalise3(&vertexNormals[i], &vertexNormals[i]);
+		}
+
+		delete[] faceNormals;
+		delete[] surroundingTriangles;
+	}
+
+	void Mesh::calculateMassProperties(MassProperties* result) const
+	{
+		// Measuring from a vertex rather than the world origin keeps the sums small far from it
+		Vector3 origin = { 0, 0, 0 };
+
+		if (vertexCount > 0)
+			origin = vertices[0];
+
+		MassAccumulator accumulator(origin);
+
+		for (int i = 0; i < indexCount; i += 3)
+			accumulator.addTriangle(&vertices[indices[i]], &vertices[indices[i + 1]], &vertices[indices[i + 2]]);
+
+		accumulator.getProperties(result);
+	}
+
+	bool Mesh::calculateConvexHull(Mesh* hull, int maxVertices) const
+	{
+		ConvexHull builder;
+		return builder.build(this, hull, maxVertices);
+	}
+
+	CutOptions::CutOptions()
+		: epsilon(1e-4f), decimator(nullptr), faceBudget(0), decimationError(1e-3f), optimiser(nullptr),
+		  leftMass(nullptr), rightMass(nullptr)
+	{
+
+	}
+
+	void Mesh::cut(Mesh* left, Mesh* right, Vector3 planePoint, Vector3 planeNormal, const CutOptions& options)
+	{
+		CutPlan plan;
+
+		planCut(&plan, planePoint, planeNormal, options);
+		materialiseCut(&plan, left, right, options);
+	}
+
+	void Mesh::planCut(CutPlan* plan, Vector3 planePoint, Vector3 planeNormal, const CutOptions& options) const
+	{
+		int faceCount = indexCount / 3;
+
+		// Distances are measured along a unit normal so that epsilon is in mesh units
+		if (length3(&planeNormal) > 0)
+			normalise3(&planeNormal, &planeNormal);
+
+		plan->reserve(vertexCount, faceCount);
+
+		plan->planePoint = planePoint;
+		plan->planeNormal = planeNormal;
+		plan->vertexCount = vertexCount;
+		plan->faceCount = faceCount;
+
+		// Classify each vertex once rather than once per face that uses it
+		float* distances = plan->distances;
+		PlaneSide* sides = plan->vertexSides;
+
+		planeDistanceBatch(vertices, &planeNormal, &planePoint, distances, vertexCount);
+
+		for (int i = 0; i < vertexCount; ++i)
+			sides[i] = classifyDistance(distances[i], options.epsilon);
+
+		classifyFaces(plan, vertices);
+	}
+
+	void Mesh::classifyFaces(CutPlan* plan, const Vector3* positions) const
+	{
+		int faceCount = indexCount / 3;
+
+		const PlaneSide* sides = plan->vertexSides;
+		Vector3 planeNormal = plan->planeNormal;
+
+		plan->leftFaceCount = 0;
+		plan->rightFaceCount = 0;
+		plan->crossingFaceCount = 0;
+
+		for (int i = 0; i < faceCount; ++i)
+		{
+			const int* face = &indices[i*3];
+
+			int pointsToLeft = (sides[face[0]] == SIDE_LEFT ? 1 : 0) + (sides[face[1]] == SIDE_LEFT ? 1 : 0) + (sides[face[2]] == SIDE_LEFT ? 1 : 0);
+			int pointsToRight = (sides[face[0]] == SIDE_RIGHT ? 1 : 0) + (sides[face[1]] == SIDE_RIGHT ? 1 : 0) + (sides[face[2]] == SIDE_RIGHT ? 1 : 0);
+
+			PlaneSide faceSide;
+
+			if (pointsToLeft > 0 && pointsToRight > 0)
 			{
-				Vector3 edge1;
-				Vector3 edge2;
-				
-				int i1 = indices[i*3 +0];
-				int i2 = indices[i*3 +1];
-				int i3 = indices[i*3 +2];
-				
-				Vector3* v1 = &vertices[i1];
-				Vector3* v2 = &vertices[i2];
-				Vector3* v3 = &vertices[i3];
-				
-				// Calculate edges
-				sub3(v3, v1, &edge1);
-				sub3(v2, v1, &edge2);
-
-				// Calculate face normal
-				cross3(&edge1, &edge2, &faceNormals[i]);
-				normalise3(&faceNormals[i], &faceNormals[i]);
-
-				// Increment vertex normals
-				add3(&vertexNormals[i1], &faceNormals[i], &vertexNormals[i1]);
-				add3(&vertexNormals[i2], &faceNormals[i], &vertexNormals[i2]);
-				add3(&vertexNormals[i3], &faceNormals[i], &vertexNormals[i3]);
-
-				// Increment triangle count for each vertex so we can average the normals
-				surroundingTriangles[i1]++;
-				surroundingTriangles[i2]++;
-				surroundingTriangles[i3]++;
+				faceSide = SIDE_ON;
+				plan->crossingFaces[plan->crossingFaceCount++] = i;
 			}
-
-			// Calculate vertex normals
-			for (int i = 0; i < vertexCount; ++i)
+			else if (pointsToLeft > 0)
+				faceSide = SIDE_LEFT;
+			else if (pointsToRight > 0)
+				faceSide = SIDE_RIGHT;
+			else
 			{
-				// Average normals
-				vertexNormals[i].x /= surroundingTriangles[i];
-				vertexNormals[i].y /= surroundingTriangles[i];
-				vertexNormals[i].z /= surroundingTriangles[i];
+				// Faces lying in the plane go to the half they face into
+				Vector3 edge1, edge2, faceNormal;
+
+				sub3(&positions[face[2]], &positions[face[0]], &edge1);
+				sub3(&positions[face[1]], &positions[face[0]], &edge2);
+				cross3(&edge1, &edge2, &faceNormal);
 
-				normalise3(&vertexNormals[i], &vertexNormals[i]);
+				faceSide = dot3(&faceNormal, &planeNormal) > 0 ? SIDE_RIGHT : SIDE_LEFT;
 			}
 
-			delete faceNormals;
-			delete surroundingTriangles;
+			if (faceSide == SIDE_LEFT)
+				++plan->leftFaceCount;
+			else if (faceSide == SIDE_RIGHT)
+				++plan->rightFaceCount;
+
+			plan->faceSides[i] = faceSide;
 		}
 	}
 
-	void Mesh::cut(Mesh* left, Mesh* right, Vector3 planePoint, Vector3 planeNormal)
+	void Mesh::materialiseCut(const CutPlan* plan, Mesh* left, Mesh* right, const CutOptions& options) const
+	{
+		materialiseCutFrom(plan, vertices, vertexNormals, left, right, options);
+	}
+
+	void Mesh::materialiseCutFrom(const CutPlan* plan, const Vector3* sourceVertices, const Vector3* sourceNormals, Mesh* left, Mesh* right, const CutOptions& options) const
 	{
 		int faceCount = indexCount / 3;
 
-		// The maximum number of vertices for the new meshes is vertexCount + faceCount * 2
-		// (two points of intersection for each face)
+		const float* distances = plan->distances;
+		const PlaneSide* sides = plan->vertexSides;
+		const PlaneSide* faceSides = plan->faceSides;
+
+		bool wantLeft = left != nullptr;
+		bool wantRight = right != nullptr;
+
+		// Every vertex is kept, plus at most two intersections for each face the plane crosses.
+		// Sizes are worked out in 64 bits, as they can pass 2^31 before the counts do.
 		int newVertexCount = vertexCount;
-		int newVertexMax = vertexCount + faceCount * 2;
+		long long newVertexMax = (long long)vertexCount + (long long)plan->crossingFaceCount * 2;
 
-		Vector3* newVertices = new Vector3[newVertexMax];
-		Vector3* newNormals = new Vector3[newVertexMax];
+		Vector3* newVertices = new Vector3[(size_t)newVertexMax];
+		Vector3* newNormals = new Vector3[(size_t)newVertexMax];
 		
-		memcpy(newVertices, vertices, vertexCount * sizeof(Vector3));
-		memcpy(newNormals, vertexNormals, vertexCount * sizeof(Vector3));
+		memcpy(newVertices, sourceVertices, vertexCount * sizeof(Vector3));
+		memcpy(newNormals, sourceNormals, vertexCount * sizeof(Vector3));
 
-		// The maximum number of indices for the new meshes is indexCount + faceCount * 9
-		// (each face could be split up into three faces)
-		int newIndexCount = indexCount;
-		int newIndexMax = indexCount + faceCount * 9;
+		// Whole faces stay whole and crossing faces split into at most two on either side
+		long long leftIndexMax = wantLeft ? ((long long)plan->leftFaceCount + (long long)plan->crossingFaceCount * 2) * 3 : 0;
+		long long rightIndexMax = wantRight ? ((long long)plan->rightFaceCount + (long long)plan->crossingFaceCount * 2) * 3 : 0;
 		
 		int leftIndexCount = 0;
-		int* leftIndices = new int[newIndexMax];
+		int* leftIndices = new int[leftIndexMax > 0 ? (size_t)leftIndexMax : 1];
 
 		int rightIndexCount = 0;
-		int* rightIndices = new int[newIndexMax];
+		int* rightIndices = new int[rightIndexMax > 0 ? (size_t)rightIndexMax : 1];
 
-		// Iterate through each face and decide which list to put it in and whether to divide it
-		for (int i = 0; i < faceCount; ++i)
+		// Intersections are shared by the two faces on each crossed edge
+		std::unordered_map<unsigned long long, int> edgeVertices;
+
+		// With adjacency the other face on an edge is found directly instead of through the map,
+		// and the halves' adjacency is filled in from the parts each source edge was split into
+		bool keepAdjacency = opposites != nullptr;
+
+		int* cornerVertices = nullptr;
+		int* faceParts = nullptr;
+		int* edgeParts = nullptr;
+		int* leftOpposites = nullptr;
+		int* rightOpposites = nullptr;
+
+		if (keepAdjacency)
 		{
-			int i1 = indices[i*3 +0];
-			int i2 = indices[i*3 +1];
-			int i3 = indices[i*3 +2];
-			
-			Vector3* v1 = &vertices[i1];
-			Vector3* v2 = &vertices[i2];
-			Vector3* v3 = &vertices[i3];
+			cornerVertices = new int[faceCount * 3];
+			faceParts = new int[faceCount];
+			edgeParts = new int[(size_t)faceCount * 6];
+			leftOpposites = new int[leftIndexMax > 0 ? (size_t)leftIndexMax : 1];
+			rightOpposites = new int[rightIndexMax > 0 ? (size_t)rightIndexMax : 1];
+		}
 
-			// Check if each vertex is to the left of the plane
-			Vector3 v1ToPlane;
-			Vector3 v2ToPlane;
-			Vector3 v3ToPlane;
-			
-			sub3(&planePoint, v1, &v1ToPlane);
-			sub3(&planePoint, v2, &v2ToPlane);
-			sub3(&planePoint, v3, &v3ToPlane);
-			
-			bool v1Left = dot3(&v1ToPlane, &planeNormal) < 0;
-			bool v2Left = dot3(&v2ToPlane, &planeNormal) < 0;
-			bool v3Left = dot3(&v3ToPlane, &planeNormal) < 0;
+		// Both halves are measured from a point on the plane, where the open cut adds nothing
+		MassProperties* leftMass = wantLeft ? options.leftMass : nullptr;
+		MassProperties* rightMass = wantRight ? options.rightMass : nullptr;
+		bool measureMass = leftMass != nullptr || rightMass != nullptr;
 
-			int pointsToLeft = (v1Left ? 1 : 0) + (v2Left ? 1 : 0) + (v3Left ? 1 : 0);
+		MassAccumulator leftAccumulator(plan->planePoint);
+		MassAccumulator rightAccumulator(plan->planePoint);
 
-			// All vertices to left
-			if (pointsToLeft == 3)
+		// Go through each face in order, copying whole faces to their half and dividing the rest
+		for (int i = 0; i < faceCount; ++i)
+		{
+			const int* face = &indices[i*3];
+
+			TriangleSplit split;
+
+			if (faceSides[i] != SIDE_ON)
 			{
-				// Add all vertices to left
-				leftIndices[leftIndexCount++] = i1;
-				leftIndices[leftIndexCount++] = i2;
-				leftIndices[leftIndexCount++] = i3;
+				split.triangleCount = 1;
+				split.sides[0] = faceSides[i];
+				split.corners[0][0] = 0;
+				split.corners[0][1] = 1;
+				split.corners[0][2] = 2;
 			}
-			// All vertices to right
-			else if (pointsToLeft == 0)
+			else
 			{
-				// Add all vertices to right
-				rightIndices[rightIndexCount++] = i1;
-				rightIndices[rightIndexCount++] = i2;
-				rightIndices[rightIndexCount++] = i3;
+				PlaneSide cornerSides[3] = { sides[face[0]], sides[face[1]], sides[face[2]] };
+				splitTriangle(cornerSides, &split);
 			}
-			// One vertex to left
-			else if (pointsToLeft == 1)
+
+			// Work out the vertex for each corner of the split, adding intersections as needed
+			int splitVertices[SPLIT_EDGE + 3] = { face[0], face[1], face[2], -1, -1, -1 };
+			int pieceParts[3];
+
+			for (int j = 0; j < split.triangleCount; ++j)
 			{
-				if (v1Left)
+				bool isLeft = split.sides[j] == SIDE_LEFT;
+
+				// Pieces of a half that isn't wanted are left out, but still make their
+				// intersections so both halves would number them the same
+				if (isLeft ? !wantLeft : !wantRight)
 				{
-					Vector3 line1, line2;
-					Vector3 intersect1, intersect2;
-
-					int intersect1index, intersect2index;
-					float intersect1coeff, intersect2coeff;
-
-					int ia = i1;
-					int ib = i2;
-					int ic = i3;
-					
-					const Vector3* a = &newVertices[ia];
-					const Vector3* b = &newVertices[ib];
-					const Vector3* c = &newVertices[ic];
-
-					sub3(b, a, &line1);
-					sub3(c, a, &line2);
-					
-					// Calculate lerp coefficient for intersections
-					intersect1coeff = linePlaneCoefficient(a, &line1, &planeNormal, &planePoint);
-					intersect2coeff = linePlaneCoefficient(a, &line2, &planeNormal, &planePoint);
-					
-					// Calculate intersections
-					lerp3(a, b, intersect1coeff, &intersect1);
-					lerp3(a, c, intersect2coeff, &intersect2);
-					
-					intersect1index = newVertexCount++;
-					intersect2index = newVertexCount++;
-					
-					// Save intersections as new vertices
-					newVertices[intersect1index] = intersect1;
-					newVertices[intersect2index] = intersect2;
-
-					lerp3(&vertexNormals[ia], &vertexNormals[ib], intersect1coeff, &newNormals[intersect1index]);
-					lerp3(&vertexNormals[ia], &vertexNormals[ic], intersect2coeff, &newNormals[intersect2index]);
-
-					// Add triangles
-					// Left
-					leftIndices[leftIndexCount++] = i1;
-					leftIndices[leftIndexCount++] = intersect1index;
-					leftIndices[leftIndexCount++] = intersect2index;
-
-					// Right
-					rightIndices[rightIndexCount++] = intersect1index;
-					rightIndices[rightIndexCount++] = i2;
-					rightIndices[rightIndexCount++] = i3;
-
-					rightIndices[rightIndexCount++] = intersect1index;
-					rightIndices[rightIndexCount++] = i3;
-					rightIndices[rightIndexCount++] = intersect2index;
+					pieceParts[j] = SKIPPED_PART;
+
+					if (split.triangleCount == 1)
+						continue;
 				}
-				else if (v2Left)
+
+				for (int k = 0; k < 3; ++k)
 				{
-					Vector3 line1, line2;
-					Vector3 intersect1, intersect2;
-					int intersect1index, intersect2index;
-					float intersect1coeff, intersect2coeff;
-
-					int ia = i2;
-					int ib = i1;
-					int ic = i3;
-					
-					const Vector3* a = &newVertices[ia];
-					const Vector3* b = &newVertices[ib];
-					const Vector3* c = &newVertices[ic];
-
-					sub3(b, a, &line1);
-					sub3(c, a, &line2);
-					
-					// Calculate lerp coefficient for intersections
-					intersect1coeff = linePlaneCoefficient(a, &line1, &planeNormal, &planePoint);
-					intersect2coeff = linePlaneCoefficient(a, &line2, &planeNormal, &planePoint);
-					
-					// Calculate intersections
-					lerp3(a, b, intersect1coeff, &intersect1);
-					lerp3(a, c, intersect2coeff, &intersect2);
-					
-					intersect1index = newVertexCount++;
-					intersect2index = newVertexCount++;
-					
-					// Save intersections as new vertices
-					newVertices[intersect1index] = intersect1;
-					newVertices[intersect2index] = intersect2;
-
-					lerp3(&vertexNormals[ia], &vertexNormals[ib], intersect1coeff, &newNormals[intersect1index]);
-					lerp3(&vertexNormals[ia], &vertexNormals[ic], intersect2coeff, &newNormals[intersect2index]);
-
-					// Add triangles
-					// Left
-					leftIndices[leftIndexCount++] = i2;
-					leftIndices[leftIndexCount++] = intersect2index;
-					leftIndices[leftIndexCount++] = intersect1index;
-
-					// Right
-					rightIndices[rightIndexCount++] = intersect1index;
-					rightIndices[rightIndexCount++] = intersect2index;
-					rightIndices[rightIndexCount++] = i3;
-
-					rightIndices[rightIndexCount++] = intersect1index;
-					rightIndices[rightIndexCount++] = i3;
-					rightIndices[rightIndexCount++] = i1;
+					int corner = split.corners[j][k];
+
+					if (splitVertices[corner] != -1)
+						continue;
+
+					int sourceCorner = i*3 + corner - SPLIT_EDGE;
+
+					// The face across the edge has already made the intersection if it came first
+					if (keepAdjacency)
+					{
+						int opposite = opposites[sourceCorner];
+
+						if (opposite != -1 && opposite / 3 < i)
+						{
+							splitVertices[corner] = cornerVertices[opposite];
+							continue;
+						}
+					}
+
+					int ia = face[corner - SPLIT_EDGE];
+					int ib = face[(corner - SPLIT_EDGE + 1) % 3];
+
+					// Always interpolate from the lower index so both faces agree on the point
+					if (ia > ib)
+					{
+						int temp = ia;
+						ia = ib;
+						ib = temp;
+					}
+
+					unsigned long long key = ((unsigned long long)ia << 32) | (unsigned int)ib;
+
+					if (!keepAdjacency)
+					{
+						std::unordered_map<unsigned long long, int>::iterator existing = edgeVertices.find(key);
+
+						if (existing != edgeVertices.end())
+						{
+							splitVertices[corner] = existing->second;
+							continue;
+						}
+					}
+
+					float intersectCoeff = distances[ia] / (distances[ia] - distances[ib]);
+					int intersectIndex = newVertexCount++;
+
+					lerp3(&sourceVertices[ia], &sourceVertices[ib], intersectCoeff, &newVertices[intersectIndex]);
+					lerp3(&sourceNormals[ia], &sourceNormals[ib], intersectCoeff, &newNormals[intersectIndex]);
+
+					if (keepAdjacency)
+						cornerVertices[sourceCorner] = intersectIndex;
+					else
+						edgeVertices[key] = intersectIndex;
+
+					splitVertices[corner] = intersectIndex;
 				}
-				else
+
+				if (isLeft ? !wantLeft : !wantRight)
+					continue;
+
+				// Add triangle
+				int* targetIndices = isLeft ? leftIndices : rightIndices;
+				int* targetCount = isLeft ? &leftIndexCount : &rightIndexCount;
+
+				pieceParts[j] = (*targetCount << 1) | (isLeft ? PART_LEFT : PART_RIGHT);
+
+				targetIndices[(*targetCount)++] = splitVertices[split.corners[j][0]];
+				targetIndices[(*targetCount)++] = splitVertices[split.corners[j][1]];
+				targetIndices[(*targetCount)++] = splitVertices[split.corners[j][2]];
+
+				if (measureMass)
 				{
-					Vector3 line1, line2;
-					Vector3 intersect1, intersect2;
-					int intersect1index, intersect2index;
-					float intersect1coeff, intersect2coeff;
-
-					int ia = i3;
-					int ib = i1;
-					int ic = i2;
-					
-					const Vector3* a = &newVertices[ia];
-					const Vector3* b = &newVertices[ib];
-					const Vector3* c = &newVertices[ic];
-
-					sub3(b, a, &line1);
-					sub3(c, a, &line2);
-					
-					// Calculate lerp coefficient for intersections
-					intersect1coeff = linePlaneCoefficient(a, &line1, &planeNormal, &planePoint);
-					intersect2coeff = linePlaneCoefficient(a, &line2, &planeNormal, &planePoint);
-					
-					// Calculate intersections
-					lerp3(a, b, intersect1coeff, &intersect1);
-					lerp3(a, c, intersect2coeff, &intersect2);
-					
-					intersect1index = newVertexCount++;
-					intersect2index = newVertexCount++;
-					
-					// Save intersections as new vertices
-					newVertices[intersect1index] = intersect1;
-					newVertices[intersect2index] = intersect2;
-
-					lerp3(&vertexNormals[ia], &vertexNormals[ib], intersect1coeff, &newNormals[intersect1index]);
-					lerp3(&vertexNormals[ia], &vertexNormals[ic], intersect2coeff, &newNormals[intersect2index]);
-
-					// Add triangles
-					// Left
-					leftIndices[leftIndexCount++] = intersect1index;
-					leftIndices[leftIndexCount++] = intersect2index;
-					leftIndices[leftIndexCount++] = i3;
-
-					// Right
-					rightIndices[rightIndexCount++] = i2;
-					rightIndices[rightIndexCount++] = intersect2index;
-					rightIndices[rightIndexCount++] = intersect1index;
-
-					rightIndices[rightIndexCount++] = i2;
-					rightIndices[rightIndexCount++] = intersect1index;
-					rightIndices[rightIndexCount++] = i1;
+					MassAccumulator* accumulator = isLeft ? &leftAccumulator : &rightAccumulator;
+
+					accumulator->addTriangle(&newVertices[splitVertices[split.corners[j][0]]],
+						&newVertices[splitVertices[split.corners[j][1]]], &newVertices[splitVertices[split.corners[j][2]]]);
 				}
 			}
-			// Two vertices to left
-			else if (pointsToLeft == 2)
+
+			if (!keepAdjacency)
+				continue;
+
+			if (split.triangleCount == 1)
 			{
-				if (!v1Left)
+				faceParts[i] = pieceParts[0];
+
+				if (pieceParts[0] != SKIPPED_PART)
 				{
-					Vector3 line1, line2;
-					Vector3 intersect1, intersect2;
-					int intersect1index, intersect2index;
-					float intersect1coeff, intersect2coeff;
-
-					int ia = i1;
-					int ib = i2;
-					int ic = i3;
-					
-					const Vector3* a = &newVertices[ia];
-					const Vector3* b = &newVertices[ib];
-					const Vector3* c = &newVertices[ic];
-
-					sub3(b, a, &line1);
-					sub3(c, a, &line2);
-					
-					// Calculate lerp coefficient for intersections
-					intersect1coeff = linePlaneCoefficient(a, &line1, &planeNormal, &planePoint);
-					intersect2coeff = linePlaneCoefficient(a, &line2, &planeNormal, &planePoint);
-					
-					// Calculate intersections
-					lerp3(a, b, intersect1coeff, &intersect1);
-					lerp3(a, c, intersect2coeff, &intersect2);
-					
-					intersect1index = newVertexCount++;
-					intersect2index = newVertexCount++;
-					
-					// Save intersections as new vertices
-					newVertices[intersect1index] = intersect1;
-					newVertices[intersect2index] = intersect2;
-
-					lerp3(&vertexNormals[ia], &vertexNormals[ib], intersect1coeff, &newNormals[intersect1index]);
-					lerp3(&vertexNormals[ia], &vertexNormals[ic], intersect2coeff, &newNormals[intersect2index]);
-
-					// Add triangles
-					// Right
-					rightIndices[rightIndexCount++] = i1;
-					rightIndices[rightIndexCount++] = intersect1index;
-					rightIndices[rightIndexCount++] = intersect2index;
-
-					// Left
-					leftIndices[leftIndexCount++] = intersect1index;
-					leftIndices[leftIndexCount++] = i2;
-					leftIndices[leftIndexCount++] = i3;
-
-					leftIndices[leftIndexCount++] = intersect1index;
-					leftIndices[leftIndexCount++] = i3;
-					leftIndices[leftIndexCount++] = intersect2index;
+					int* targetOpposites = (pieceParts[0] & 1) == PART_LEFT ? leftOpposites : rightOpposites;
+
+					targetOpposites[(pieceParts[0] >> 1) + 0] = -1;
+					targetOpposites[(pieceParts[0] >> 1) + 1] = -1;
+					targetOpposites[(pieceParts[0] >> 1) + 2] = -1;
 				}
-				else if (!v2Left)
+			}
+			else
+			{
+				faceParts[i] = -1;
+
+				// Sort the pieces' half edges into parts of the source edges and edges inside the face
+				int innerParts[9];
+				int innerFrom[9], innerTo[9];
+				int innerCount = 0;
+
+				for (int j = 0; j < split.triangleCount; ++j)
 				{
-					Vector3 line1, line2;
-					Vector3 intersect1, intersect2;
-					int intersect1index, intersect2index;
-					float intersect1coeff, intersect2coeff;
-
-					int ia = i2;
-					int ib = i1;
-					int ic = i3;
-					
-					const Vector3* a = &newVertices[ia];
-					const Vector3* b = &newVertices[ib];
-					const Vector3* c = &newVertices[ic];
-
-					sub3(b, a, &line1);
-					sub3(c, a, &line2);
-					
-					// Calculate lerp coefficient for intersections
-					intersect1coeff = linePlaneCoefficient(a, &line1, &planeNormal, &planePoint);
-					intersect2coeff = linePlaneCoefficient(a, &line2, &planeNormal, &planePoint);
-					
-					// Calculate intersections
-					lerp3(a, b, intersect1coeff, &intersect1);
-					lerp3(a, c, intersect2coeff, &intersect2);
-					
-					intersect1index = newVertexCount++;
-					intersect2index = newVertexCount++;
-					
-					// Save intersections as new vertices
-					newVertices[intersect1index] = intersect1;
-					newVertices[intersect2index] = intersect2;
-
-					lerp3(&vertexNormals[ia], &vertexNormals[ib], intersect1coeff, &newNormals[intersect1index]);
-					lerp3(&vertexNormals[ia], &vertexNormals[ic], intersect2coeff, &newNormals[intersect2index]);
-
-					// Add triangles
-					// Right
-					rightIndices[rightIndexCount++] = i2;
-					rightIndices[rightIndexCount++] = intersect2index;
-					rightIndices[rightIndexCount++] = intersect1index;
-
-					// Left
-					leftIndices[leftIndexCount++] = intersect1index;
-					leftIndices[leftIndexCount++] = intersect2index;
-					leftIndices[leftIndexCount++] = i3;
-
-					leftIndices[leftIndexCount++] = intersect1index;
-					leftIndices[leftIndexCount++] = i3;
-					leftIndices[leftIndexCount++] = i1;
+					int* targetOpposites = (pieceParts[j] & 1) == PART_LEFT ? leftOpposites : rightOpposites;
+
+					for (int k = 0; k < 3; ++k)
+					{
+						int from = split.corners[j][k];
+						int to = split.corners[j][(k + 1) % 3];
+						int part = pieceParts[j] == SKIPPED_PART ? SKIPPED_PART : pieceParts[j] + (k << 1);
+
+						if (part != SKIPPED_PART)
+							targetOpposites[part >> 1] = -1;
+
+						if (from < SPLIT_EDGE && to == (from + 1) % 3)
+						{
+							edgeParts[(size_t)(i*3 + from) * 2] = part;
+							edgeParts[(size_t)(i*3 + from) * 2 + 1] = -1;
+						}
+						else if (from < SPLIT_EDGE && to == SPLIT_EDGE + from)
+							edgeParts[(size_t)(i*3 + from) * 2] = part;
+						else if (from >= SPLIT_EDGE && to == (from - SPLIT_EDGE + 1) % 3)
+							edgeParts[(size_t)(i*3 + from - SPLIT_EDGE) * 2 + 1] = part;
+						else
+						{
+							innerParts[innerCount] = part;
+							innerFrom[innerCount] = from;
+							innerTo[innerCount] = to;
+							++innerCount;
+						}
+					}
 				}
-				else if (!v3Left)
+
+				// Edges inside the face pair up within it, unless they are on the cut
+				for (int j = 0; j < innerCount; ++j)
+					for (int k = j + 1; k < innerCount; ++k)
+						if (innerFrom[j] == innerTo[k] && innerTo[j] == innerFrom[k])
+							pairEdgeParts(innerParts[j], innerParts[k], leftOpposites, rightOpposites);
+			}
+
+			// Pair up the parts of this face's edges with those of faces already written
+			for (int k = 0; k < 3; ++k)
+			{
+				int corner = i*3 + k;
+				int opposite = opposites[corner];
+
+				if (opposite == -1 || opposite / 3 > i || (opposite / 3 == i && opposite > corner))
+					continue;
+
+				int first, second, oppositeFirst, oppositeSecond;
+
+				getEdgeParts(corner, faceParts, edgeParts, &first, &second);
+				getEdgeParts(opposite, faceParts, edgeParts, &oppositeFirst, &oppositeSecond);
+
+				if (second == -1)
+					pairEdgeParts(first, oppositeFirst, leftOpposites, rightOpposites);
+				else
 				{
-					Vector3 line1, line2;
-					Vector3 intersect1, intersect2;
-					int intersect1index, intersect2index;
-					float intersect1coeff, intersect2coeff;
-
-					int ia = i3;
-					int ib = i1;
-					int ic = i2;
-					
-					const Vector3* a = &newVertices[ia];
-					const Vector3* b = &newVertices[ib];
-					const Vector3* c = &newVertices[ic];
-
-					sub3(b, a, &line1);
-					sub3(c, a, &line2);
-					
-					// Calculate lerp coefficient for intersections
-					intersect1coeff = linePlaneCoefficient(a, &line1, &planeNormal, &planePoint);
-					intersect2coeff = linePlaneCoefficient(a, &line2, &planeNormal, &planePoint);
-					
-					// Calculate intersections
-					lerp3(a, b, intersect1coeff, &intersect1);
-					lerp3(a, c, intersect2coeff, &intersect2);
-					
-					intersect1index = newVertexCount++;
-					intersect2index = newVertexCount++;
-					
-					// Save intersections as new vertices
-					newVertices[intersect1index] = intersect1;
-					newVertices[intersect2index] = intersect2;
-
-					lerp3(&vertexNormals[ia], &vertexNormals[ib], intersect1coeff, &newNormals[intersect1index]);
-					lerp3(&vertexNormals[ia], &vertexNormals[ic], intersect2coeff, &newNormals[intersect2index]);
-
-					// Add triangles
-					// Right
-					rightIndices[rightIndexCount++] = intersect1index;
-					rightIndices[rightIndexCount++] = intersect2index;
-					rightIndices[rightIndexCount++] = i3;
-
-					// Left
-					leftIndices[leftIndexCount++] = i2;
-					leftIndices[leftIndexCount++] = intersect2index;
-					leftIndices[leftIndexCount++] = intersect1index;
-
-					leftIndices[leftIndexCount++] = i2;
-					leftIndices[leftIndexCount++] = intersect1index;
-					leftIndices[leftIndexCount++] = i1;
+					pairEdgeParts(first, oppositeSecond, leftOpposites, rightOpposites);
+					pairEdgeParts(second, oppositeFirst, leftOpposites, rightOpposites);
 				}
 			}
-			else
+		}
+
+		Mesh* halves[2] = { left, right };
+		int* halfIndices[2] = { leftIndices, rightIndices };
+		int halfIndexCounts[2] = { leftIndexCount, rightIndexCount };
+		int* halfOpposites[2] = { leftOpposites, rightOpposites };
+
+		for (int i = 0; i < 2; ++i)
+		{
+			Mesh* half = halves[i];
+
+			if (half == nullptr)
+				continue;
+
+			MemoryResource* resource = half->getMemoryResource();
+
+			freeArray(resource, half->vertices);
+			freeArray(resource, half->vertexNormals);
+			freeArray(resource, half->indices);
+
+			// Texture coordinates aren't carried through the cut, so don't leave stale ones behind
+			freeArray(resource, half->texCoords);
+			half->texCoords = nullptr;
+
+			half->vertices = allocateArray<Vector3>(resource, newVertexCount);
+			half->vertexNormals = allocateArray<Vector3>(resource, newVertexCount);
+			half->indices = allocateArray<int>(resource, halfIndexCounts[i]);
+
+			half->vertexCount = newVertexCount;
+			half->indexCount = halfIndexCounts[i];
+			half->vertexCapacity = newVertexCount;
+			half->indexCapacity = halfIndexCounts[i];
+
+			memcpy(half->vertices, newVertices, half->vertexCount * sizeof(Vector3));
+			memcpy(half->vertexNormals, newNormals, half->vertexCount * sizeof(Vector3));
+			memcpy(half->indices, halfIndices[i], half->indexCount * sizeof(int));
+
+			half->clearAdjacency();
+			half->markChanged();
+
+			if (keepAdjacency)
 			{
-				int j = 0;
+				half->opposites = allocateArray<int>(resource, halfIndexCounts[i]);
+				memcpy(half->opposites, halfOpposites[i], halfIndexCounts[i] * sizeof(int));
 			}
 		}
 
-		delete left->vertices;
-		delete left->vertexNormals;
-		delete left->indices;
+		if (keepAdjacency)
+		{
+			delete[] cornerVertices;
+			delete[] faceParts;
+			delete[] edgeParts;
+			delete[] leftOpposites;
+			delete[] rightOpposites;
+		}
 
-		delete right->vertices;
-		delete right->vertexNormals;
-		delete right->indices;
+		delete[] newVertices;
+		delete[] newNormals;
+		delete[] leftIndices;
+		delete[] rightIndices;
 
-		left->vertices = new Vector3[newVertexCount];
-		left->vertexNormals = new Vector3[newVertexCount];
-		left->indices = new int[leftIndexCount];
+		if (leftMass != nullptr)
+			leftAccumulator.getProperties(leftMass);
 
-		left->vertexCount = newVertexCount;
-		left->indexCount = leftIndexCount;
-		
-		memcpy(left->vertices, newVertices, left->vertexCount * sizeof(Vector3));
-		memcpy(left->vertexNormals, newNormals, left->vertexCount * sizeof(Vector3));
-		memcpy(left->indices, leftIndices, left->indexCount * sizeof(int));
+		if (rightMass != nullptr)
+			rightAccumulator.getProperties(rightMass);
 
-		right->vertices = new Vector3[newVertexCount];
-		right->vertexNormals = new Vector3[newVertexCount];
-		right->indices = new int[rightIndexCount];
+		for (int i = 0; i < 2; ++i)
+		{
+			if (halves[i] == nullptr)
+				continue;
 
-		right->vertexCount = newVertexCount;
-		right->indexCount = rightIndexCount;
-		
-		memcpy(right->vertices, newVertices, right->vertexCount * sizeof(Vector3));
-		memcpy(right->vertexNormals, newNormals, right->vertexCount * sizeof(Vector3));
-		memcpy(right->indices, rightIndices, right->indexCount * sizeof(int));
-
-		delete newVertices;
-		delete newNormals;
-		delete leftIndices;
-		delete rightIndices;
+			if (options.decimator != nullptr)
+			{
+				// Vertices from vertexCount on are the intersections, so start with the faces around them
+				options.decimator->decimate(halves[i], options.faceBudget, vertexCount, options.decimationError);
+
+				if (halves[i]->indexCount / 3 > options.faceBudget)
+					options.decimator->decimate(halves[i], options.faceBudget);
+			}
+
+			if (options.optimiser != nullptr)
+				options.optimiser->optimise(halves[i]);
+		}
 	}
 }
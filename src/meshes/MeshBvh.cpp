@@ -0,0 +1,174 @@
+#include "meshes/MeshBvh.h"
+#include "meshes/Mesh.h"
+
+#include <float.h>
+#include <algorithm>
+
+namespace cut
+{
+	namespace
+	{
+		const int LEAF_FACES = 4;
+
+		float component(const Vector3* vector, int axis)
+		{
+			return axis == 0 ? vector->x : (axis == 1 ? vector->y : vector->z);
+		}
+
+		void growBounds(Vector3* boundsMin, Vector3* boundsMax, const Vector3* point)
+		{
+			boundsMin->x = std::min(boundsMin->x, point->x);
+			boundsMin->y = std::min(boundsMin->y, point->y);
+			boundsMin->z = std::min(boundsMin->z, point->z);
+			boundsMax->x = std::max(boundsMax->x, point->x);
+			boundsMax->y = std::max(boundsMax->y, point->y);
+			boundsMax->z = std::max(boundsMax->z, point->z);
+		}
+
+		bool overlaps(const Vector3* firstMin, const Vector3* firstMax, const Vector3* secondMin, const Vector3* secondMax)
+		{
+			return firstMin->x <= secondMax->x && firstMax->x >= secondMin->x
+				&& firstMin->y <= secondMax->y && firstMax->y >= secondMin->y
+				&& firstMin->z <= secondMax->z && firstMax->z >= secondMin->z;
+		}
+	}
+
+	MeshBvh::MeshBvh()
+	{
+
+	}
+
+	void MeshBvh::build(const Mesh* mesh)
+	{
+		int faceCount = mesh->indexCount / 3;
+
+		nodes.clear();
+		faceOrder.resize(faceCount);
+		nextPiece.assign(faceCount, -1);
+
+		if (faceCount == 0)
+			return;
+
+		// Face bounds and centres, for the median splits
+		std::vector<Vector3> faceMin(faceCount), faceMax(faceCount), centres(faceCount);
+
+		for (int i = 0; i < faceCount; ++i)
+		{
+			faceOrder[i] = i;
+
+			faceMin[i] = faceMax[i] = mesh->vertices[mesh->indices[i * 3]];
+
+			growBounds(&faceMin[i], &faceMax[i], &mesh->vertices[mesh->indices[i * 3 + 1]]);
+			growBounds(&faceMin[i], &faceMax[i], &mesh->vertices[mesh->indices[i * 3 + 2]]);
+
+			add3(&faceMin[i], &faceMax[i], &centres[i]);
+		}
+
+		struct Range
+		{
+			int node;
+			int begin, end;
+		};
+
+		std::vector<Range> stack;
+
+		Node root = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, 0, 0 };
+		nodes.push_back(root);
+
+		Range all = { 0, 0, faceCount };
+		stack.push_back(all);
+
+		while (!stack.empty())
+		{
+			Range range = stack.back();
+			stack.pop_back();
+
+			Vector3 boundsMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+			Vector3 boundsMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			Vector3 centreMin = boundsMin;
+			Vector3 centreMax = boundsMax;
+
+			for (int i = range.begin; i < range.end; ++i)
+			{
+				int face = faceOrder[i];
+
+				growBounds(&boundsMin, &boundsMax, &faceMin[face]);
+				growBounds(&boundsMin, &boundsMax, &faceMax[face]);
+				growBounds(&centreMin, &centreMax, &centres[face]);
+			}
+
+			nodes[range.node].boundsMin = boundsMin;
+			nodes[range.node].boundsMax = boundsMax;
+
+			if (range.end - range.begin <= LEAF_FACES)
+			{
+				nodes[range.node].first = range.begin;
+				nodes[range.node].faceCount = range.end - range.begin;
+				continue;
+			}
+
+			// Split at the median along the axis the centres spread furthest on
+			Vector3 extent;
+			sub3(&centreMax, &centreMin, &extent);
+
+			int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+			int middle = (range.begin + range.end) / 2;
+
+			std::nth_element(faceOrder.begin() + range.begin, faceOrder.begin() + middle, faceOrder.begin() + range.end,
+				[&](int first, int second) { return component(&centres[first], axis) < component(&centres[second], axis); });
+
+			int children = (int)nodes.size();
+
+			nodes[range.node].first = children;
+			nodes[range.node].faceCount = 0;
+
+			nodes.push_back(root);
+			nodes.push_back(root);
+
+			Range left = { children, range.begin, middle };
+			Range right = { children + 1, middle, range.end };
+
+			stack.push_back(left);
+			stack.push_back(right);
+		}
+	}
+
+	void MeshBvh::query(const Vector3* boxMin, const Vector3* boxMax, std::vector<int>* faces) const
+	{
+		if (nodes.empty())
+			return;
+
+		int stack[64];
+		int stackSize = 0;
+
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const Node* node = &nodes[stack[--stackSize]];
+
+			if (!overlaps(&node->boundsMin, &node->boundsMax, boxMin, boxMax))
+				continue;
+
+			if (node->faceCount == 0)
+			{
+				stack[stackSize++] = node->first;
+				stack[stackSize++] = node->first + 1;
+				continue;
+			}
+
+			for (int i = node->first; i < node->first + node->faceCount; ++i)
+				for (int face = faceOrder[i]; face != -1; face = nextPiece[face])
+					faces->push_back(face);
+		}
+	}
+
+	void MeshBvh::addPiece(int face, int piece)
+	{
+		if (piece >= (int)nextPiece.size())
+			nextPiece.resize(piece + 1, -1);
+
+		nextPiece[piece] = nextPiece[face];
+		nextPiece[face] = piece;
+	}
+}
@@ -0,0 +1,196 @@
+#include "meshes/MeshLoader.h"
+
+#include "benchmark/Timer.h"
+#include "meshes/Mesh.h"
+#include "threading/ThreadPool.h"
+
+#include <stdio.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace cut
+{
+	namespace
+	{
+		struct ReadFile
+		{
+			int index;
+			char* text;
+		};
+
+		// Files read and waiting to be parsed. Tasks on the pool and the calling thread all take
+		// them from the same queue, so a task that finds it empty has nothing left to do, even if
+		// it starts after the batch has finished.
+		struct LoadJob
+		{
+			Mesh* meshes;
+			LoadTiming* timings;
+			double startTime;
+
+			std::deque<ReadFile> queue;
+			int parsing;
+
+			std::mutex mutex;
+			std::condition_variable progress;
+
+			bool parseNext()
+			{
+				ReadFile file;
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+
+					if (queue.empty())
+						return false;
+
+					file = queue.front();
+					queue.pop_front();
+					parsing++;
+				}
+
+				Mesh* mesh = &meshes[file.index];
+
+				double start = getTime();
+				mesh->parseObj(file.text);
+				double parsed = getTime();
+				mesh->calculateNormals();
+				double end = getTime();
+
+				delete[] file.text;
+
+				if (timings != nullptr)
+				{
+					timings[file.index].parseTime = parsed - start;
+					timings[file.index].normalsTime = end - parsed;
+					timings[file.index].readyTime = end - startTime;
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					parsing--;
+				}
+
+				progress.notify_all();
+
+				return true;
+			}
+		};
+	}
+
+	char* readTextFile(const char* filename, size_t* length)
+	{
+		FILE* file = fopen(filename, "rb");
+
+		if (file == nullptr)
+			return nullptr;
+
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		if (size < 0)
+		{
+			fclose(file);
+			return nullptr;
+		}
+
+		char* text = new char[size + 1];
+		size_t read = fread(text, 1, size, file);
+
+		fclose(file);
+
+		if (read != (size_t)size)
+		{
+			delete[] text;
+			return nullptr;
+		}
+
+		text[size] = '\0';
+
+		if (length != nullptr)
+			*length = (size_t)size;
+
+		return text;
+	}
+
+	int loadObjBatch(const char* const* filenames, Mesh* meshes, LoadTiming* timings, int count, ThreadPool* pool)
+	{
+		if (pool == nullptr)
+			pool = ThreadPool::getDefault();
+
+		std::shared_ptr<LoadJob> job(new LoadJob());
+		job->meshes = meshes;
+		job->timings = timings;
+		job->startTime = getTime();
+		job->parsing = 0;
+
+		// Enough read ahead to keep every thread parsing, without holding every file at once
+		size_t maxInFlight = (size_t)pool->getThreadCount() * 2 + 1;
+		int loaded = 0;
+
+		for (int i = 0; i < count; ++i)
+		{
+			// Wait for room, helping with the parsing rather than waiting if there's any queued
+			for (;;)
+			{
+				{
+					std::unique_lock<std::mutex> lock(job->mutex);
+
+					if (job->queue.size() + job->parsing < maxInFlight)
+						break;
+
+					if (job->queue.empty())
+					{
+						job->progress.wait(lock);
+						continue;
+					}
+				}
+
+				job->parseNext();
+			}
+
+			double start = getTime();
+			char* text = readTextFile(filenames[i], nullptr);
+			double end = getTime();
+
+			if (timings != nullptr)
+			{
+				timings[i].readTime = end - start;
+				timings[i].parseTime = 0;
+				timings[i].normalsTime = 0;
+				timings[i].readyTime = end - job->startTime;
+			}
+
+			if (text == nullptr)
+			{
+				char empty[1] = { '\0' };
+				meshes[i].parseObj(empty);
+				continue;
+			}
+
+			ReadFile file = { i, text };
+
+			{
+				std::lock_guard<std::mutex> lock(job->mutex);
+				job->queue.push_back(file);
+			}
+
+			pool->submit([job]() { job->parseNext(); });
+
+			loaded++;
+		}
+
+		// Everything is read, so help with whatever hasn't been parsed yet
+		while (job->parseNext())
+		{
+		}
+
+		std::unique_lock<std::mutex> lock(job->mutex);
+		while (job->parsing > 0)
+			job->progress.wait(lock);
+
+		return loaded;
+	}
+}
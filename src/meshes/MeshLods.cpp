@@ -0,0 +1,89 @@
+#include "meshes/MeshLods.h"
+#include "meshes/Mesh.h"
+
+#include <stddef.h>
+
+namespace cut
+{
+	MeshLods::MeshLods()
+		: mesh(nullptr), version(0)
+	{
+
+	}
+
+	MeshLods::~MeshLods()
+	{
+		release();
+	}
+
+	void MeshLods::build(const Mesh* mesh, float ratio, int minFaceCount, int maxLevelCount)
+	{
+		release();
+
+		this->mesh = mesh;
+		version = mesh->getVersion();
+
+		const Mesh* previous = mesh;
+
+		while ((int)levels.size() + 1 < maxLevelCount)
+		{
+			int faceCount = previous->indexCount / 3;
+
+			if (faceCount <= minFaceCount)
+				break;
+
+			int targetFaceCount = (int)(faceCount * ratio);
+
+			if (targetFaceCount < minFaceCount)
+				targetFaceCount = minFaceCount;
+
+			Mesh* level = new Mesh();
+
+			previous->copyTo(level);
+			decimator.decimate(level, targetFaceCount);
+
+			// Stop once nothing more can be collapsed
+			if (level->indexCount / 3 >= faceCount)
+			{
+				delete level;
+				break;
+			}
+
+			levels.push_back(level);
+			previous = level;
+		}
+	}
+
+	int MeshLods::getLevelCount() const
+	{
+		return mesh != nullptr ? (int)levels.size() + 1 : 0;
+	}
+
+	const Mesh* MeshLods::getLevel(int level) const
+	{
+		return level == 0 ? mesh : levels[level - 1];
+	}
+
+	int MeshLods::findLevel(int maxFaceCount) const
+	{
+		for (int i = 0; i < getLevelCount(); ++i)
+			if (getLevel(i)->indexCount / 3 <= maxFaceCount)
+				return i;
+
+		return getLevelCount() - 1;
+	}
+
+	bool MeshLods::isCurrent() const
+	{
+		return mesh != nullptr && mesh->getVersion() == version;
+	}
+
+	void MeshLods::release()
+	{
+		for (size_t i = 0; i < levels.size(); ++i)
+			delete levels[i];
+
+		levels.clear();
+		mesh = nullptr;
+	}
+}
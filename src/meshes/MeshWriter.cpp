@@ -0,0 +1,383 @@
+#include "meshes/MeshWriter.h"
+#include "meshes/Mesh.h"
+#include "threading/ThreadPool.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sstream>
+#include <string>
+
+namespace cut
+{
+	namespace
+	{
+		// Elements staged at a time for formats that interleave
+		const int STAGING_COUNT = 16384;
+
+		// Large writes go straight through, and this keeps the small ones from being syscalls
+		const size_t FILE_BUFFER_SIZE = 1 << 20;
+
+		const unsigned int GLB_MAGIC = 0x46546C67;
+		const unsigned int GLB_VERSION = 2;
+		const unsigned int GLB_CHUNK_JSON = 0x4E4F534A;
+		const unsigned int GLB_CHUNK_BIN = 0x004E4942;
+
+		FILE* openForWriting(const char* filename)
+		{
+			FILE* file = fopen(filename, "wb");
+
+			if (file != NULL)
+				setvbuf(file, NULL, _IOFBF, FILE_BUFFER_SIZE);
+
+			return file;
+		}
+
+		bool closeFile(FILE* file)
+		{
+			bool success = ferror(file) == 0;
+
+			if (fclose(file) != 0)
+				success = false;
+
+			return success;
+		}
+
+		// Faces are clockwise in a Mesh and counter-clockwise in the files, so a, b, c is
+		// written as a, c, b
+		void writeFaceIndices(const Mesh* mesh, int face, unsigned char* target)
+		{
+			const int* indices = &mesh->indices[face * 3];
+			int written[3] = { indices[0], indices[2], indices[1] };
+
+			memcpy(target, written, sizeof(written));
+		}
+
+		// The normal of the face as written, by the right-hand rule
+		void writeFaceNormal(const Vector3* a, const Vector3* b, const Vector3* c, unsigned char* target)
+		{
+			Vector3 edge1, edge2, normal;
+
+			sub3(b, a, &edge1);
+			sub3(c, a, &edge2);
+			cross3(&edge1, &edge2, &normal);
+
+			if (length3(&normal) > 0)
+				normalise3(&normal, &normal);
+
+			memcpy(target, &normal, sizeof(Vector3));
+		}
+	}
+
+	bool savePly(const Mesh* mesh, const char* filename)
+	{
+		FILE* file = openForWriting(filename);
+
+		if (file == NULL)
+			return false;
+
+		int faceCount = mesh->indexCount / 3;
+		bool hasNormals = mesh->vertexNormals != nullptr;
+		bool hasTexCoords = mesh->texCoords != nullptr;
+
+		fprintf(file, "ply\nformat binary_little_endian 1.0\n");
+		fprintf(file, "element vertex %d\nproperty float x\nproperty float y\nproperty float z\n", mesh->vertexCount);
+
+		if (hasNormals)
+			fprintf(file, "property float nx\nproperty float ny\nproperty float nz\n");
+
+		if (hasTexCoords)
+			fprintf(file, "property float u\nproperty float v\n");
+
+		fprintf(file, "element face %d\nproperty list uchar int vertex_indices\nend_header\n", faceCount);
+
+		// Positions alone are already laid out as PLY wants them
+		if (!hasNormals && !hasTexCoords)
+			fwrite(mesh->vertices, sizeof(Vector3), mesh->vertexCount, file);
+		else
+		{
+			size_t vertexSize = sizeof(Vector3) + (hasNormals ? sizeof(Vector3) : 0) + (hasTexCoords ? sizeof(Vector2) : 0);
+			unsigned char* staging = new unsigned char[STAGING_COUNT * vertexSize];
+
+			for (int begin = 0; begin < mesh->vertexCount; begin += STAGING_COUNT)
+			{
+				int end = begin + STAGING_COUNT < mesh->vertexCount ? begin + STAGING_COUNT : mesh->vertexCount;
+				unsigned char* target = staging;
+
+				for (int i = begin; i < end; ++i)
+				{
+					memcpy(target, &mesh->vertices[i], sizeof(Vector3));
+					target += sizeof(Vector3);
+
+					if (hasNormals)
+					{
+						memcpy(target, &mesh->vertexNormals[i], sizeof(Vector3));
+						target += sizeof(Vector3);
+					}
+
+					if (hasTexCoords)
+					{
+						memcpy(target, &mesh->texCoords[i], sizeof(Vector2));
+						target += sizeof(Vector2);
+					}
+				}
+
+				fwrite(staging, 1, target - staging, file);
+			}
+
+			delete[] staging;
+		}
+
+		// Each face is a count byte followed by three indices
+		const size_t faceSize = 1 + 3 * sizeof(int);
+		unsigned char* staging = new unsigned char[STAGING_COUNT * faceSize];
+
+		for (int begin = 0; begin < faceCount; begin += STAGING_COUNT)
+		{
+			int end = begin + STAGING_COUNT < faceCount ? begin + STAGING_COUNT : faceCount;
+			unsigned char* target = staging;
+
+			for (int i = begin; i < end; ++i)
+			{
+				*target = 3;
+				writeFaceIndices(mesh, i, target + 1);
+				target += faceSize;
+			}
+
+			fwrite(staging, 1, target - staging, file);
+		}
+
+		delete[] staging;
+
+		return closeFile(file);
+	}
+
+	bool saveStl(const Mesh* mesh, const char* filename)
+	{
+		FILE* file = openForWriting(filename);
+
+		if (file == NULL)
+			return false;
+
+		unsigned char header[80];
+		memset(header, 0, sizeof(header));
+
+		unsigned int faceCount = mesh->indexCount / 3;
+
+		fwrite(header, 1, sizeof(header), file);
+		fwrite(&faceCount, sizeof(faceCount), 1, file);
+
+		// Each face is its normal, its three corners and a two byte attribute count
+		const size_t faceSize = 4 * sizeof(Vector3) + 2;
+		unsigned char* staging = new unsigned char[STAGING_COUNT * faceSize];
+
+		for (int begin = 0; begin < (int)faceCount; begin += STAGING_COUNT)
+		{
+			int end = begin + STAGING_COUNT < (int)faceCount ? begin + STAGING_COUNT : (int)faceCount;
+			unsigned char* target = staging;
+
+			for (int i = begin; i < end; ++i)
+			{
+				const Vector3* a = &mesh->vertices[mesh->indices[i * 3]];
+				const Vector3* b = &mesh->vertices[mesh->indices[i * 3 + 2]];
+				const Vector3* c = &mesh->vertices[mesh->indices[i * 3 + 1]];
+
+				writeFaceNormal(a, b, c, target);
+
+				memcpy(target + sizeof(Vector3), a, sizeof(Vector3));
+				memcpy(target + 2 * sizeof(Vector3), b, sizeof(Vector3));
+				memcpy(target + 3 * sizeof(Vector3), c, sizeof(Vector3));
+
+				target[4 * sizeof(Vector3)] = 0;
+				target[4 * sizeof(Vector3) + 1] = 0;
+
+				target += faceSize;
+			}
+
+			fwrite(staging, 1, target - staging, file);
+		}
+
+		delete[] staging;
+
+		return closeFile(file);
+	}
+
+	bool saveGlb(const Mesh* mesh, const char* filename)
+	{
+		// glTF has no empty buffer views or accessors, so there's nothing valid to write
+		if (mesh->vertexCount == 0 || mesh->indexCount < 3)
+			return false;
+
+		bool hasNormals = mesh->vertexNormals != nullptr;
+		bool hasTexCoords = mesh->texCoords != nullptr;
+
+		// The binary chunk holds each array whole, one after the other. Every element is a
+		// multiple of four bytes, so no padding is needed between them.
+		unsigned long long positionBytes = (unsigned long long)mesh->vertexCount * sizeof(Vector3);
+		unsigned long long normalBytes = hasNormals ? positionBytes : 0;
+		unsigned long long texCoordBytes = hasTexCoords ? (unsigned long long)mesh->vertexCount * sizeof(Vector2) : 0;
+		int faceCount = mesh->indexCount / 3;
+		unsigned long long indexBytes = (unsigned long long)faceCount * 3 * sizeof(int);
+		unsigned long long binaryBytes = positionBytes + normalBytes + texCoordBytes + indexBytes;
+
+		// Accessors for positions need their bounds
+		Vector3 boundsMin = { 0, 0, 0 };
+		Vector3 boundsMax = { 0, 0, 0 };
+
+		if (mesh->vertexCount > 0)
+		{
+			boundsMin = mesh->vertices[0];
+			boundsMax = mesh->vertices[0];
+		}
+
+		for (int i = 1; i < mesh->vertexCount; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				if (mesh->vertices[i].data[j] < boundsMin.data[j])
+					boundsMin.data[j] = mesh->vertices[i].data[j];
+
+				if (mesh->vertices[i].data[j] > boundsMax.data[j])
+					boundsMax.data[j] = mesh->vertices[i].data[j];
+			}
+		}
+
+		std::ostringstream json;
+		json.precision(9);
+
+		int view = 0;
+		unsigned long long offset = 0;
+
+		json << "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],";
+		json << "\"buffers\":[{\"byteLength\":" << binaryBytes << "}],\"bufferViews\":[";
+
+		json << "{\"buffer\":0,\"byteOffset\":" << offset << ",\"byteLength\":" << positionBytes << ",\"target\":34962}";
+		offset += positionBytes;
+
+		if (hasNormals)
+		{
+			json << ",{\"buffer\":0,\"byteOffset\":" << offset << ",\"byteLength\":" << normalBytes << ",\"target\":34962}";
+			offset += normalBytes;
+		}
+
+		if (hasTexCoords)
+		{
+			json << ",{\"buffer\":0,\"byteOffset\":" << offset << ",\"byteLength\":" << texCoordBytes << ",\"target\":34962}";
+			offset += texCoordBytes;
+		}
+
+		json << ",{\"buffer\":0,\"byteOffset\":" << offset << ",\"byteLength\":" << indexBytes << ",\"target\":34963}],\"accessors\":[";
+
+		json << "{\"bufferView\":" << view++ << ",\"componentType\":5126,\"count\":" << mesh->vertexCount << ",\"type\":\"VEC3\",";
+		json << "\"min\":[" << boundsMin.x << "," << boundsMin.y << "," << boundsMin.z << "],";
+		json << "\"max\":[" << boundsMax.x << "," << boundsMax.y << "," << boundsMax.z << "]}";
+
+		std::ostringstream attributes;
+		attributes << "\"POSITION\":0";
+
+		if (hasNormals)
+		{
+			attributes << ",\"NORMAL\":" << view;
+			json << ",{\"bufferView\":" << view++ << ",\"componentType\":5126,\"count\":" << mesh->vertexCount << ",\"type\":\"VEC3\"}";
+		}
+
+		if (hasTexCoords)
+		{
+			attributes << ",\"TEXCOORD_0\":" << view;
+			json << ",{\"bufferView\":" << view++ << ",\"componentType\":5126,\"count\":" << mesh->vertexCount << ",\"type\":\"VEC2\"}";
+		}
+
+		int indexAccessor = view;
+		json << ",{\"bufferView\":" << view++ << ",\"componentType\":5125,\"count\":" << faceCount * 3 << ",\"type\":\"SCALAR\"}],";
+
+		json << "\"meshes\":[{\"primitives\":[{\"attributes\":{" << attributes.str() << "},\"indices\":" << indexAccessor << ",\"mode\":4}]}]}";
+
+		// Chunks are padded to four bytes, JSON with spaces
+		std::string jsonText = json.str();
+
+		while (jsonText.size() % 4 != 0)
+			jsonText += ' ';
+
+		unsigned long long totalBytes = 12 + 8 + jsonText.size() + 8 + binaryBytes;
+
+		// Lengths in the container are 32 bit
+		if (totalBytes > 0xFFFFFFFFull)
+			return false;
+
+		FILE* file = openForWriting(filename);
+
+		if (file == NULL)
+			return false;
+
+		unsigned int header[3] = { GLB_MAGIC, GLB_VERSION, (unsigned int)totalBytes };
+		unsigned int jsonHeader[2] = { (unsigned int)jsonText.size(), GLB_CHUNK_JSON };
+		unsigned int binaryHeader[2] = { (unsigned int)binaryBytes, GLB_CHUNK_BIN };
+
+		fwrite(header, sizeof(header), 1, file);
+		fwrite(jsonHeader, sizeof(jsonHeader), 1, file);
+		fwrite(jsonText.data(), 1, jsonText.size(), file);
+		fwrite(binaryHeader, sizeof(binaryHeader), 1, file);
+
+		fwrite(mesh->vertices, sizeof(Vector3), mesh->vertexCount, file);
+
+		if (hasNormals)
+			fwrite(mesh->vertexNormals, sizeof(Vector3), mesh->vertexCount, file);
+
+		if (hasTexCoords)
+			fwrite(mesh->texCoords, sizeof(Vector2), mesh->vertexCount, file);
+
+		// Indices go through staging to turn the faces around
+		const size_t faceSize = 3 * sizeof(int);
+		unsigned char* staging = new unsigned char[STAGING_COUNT * faceSize];
+
+		for (int begin = 0; begin < faceCount; begin += STAGING_COUNT)
+		{
+			int end = begin + STAGING_COUNT < faceCount ? begin + STAGING_COUNT : faceCount;
+			unsigned char* target = staging;
+
+			for (int i = begin; i < end; ++i)
+			{
+				writeFaceIndices(mesh, i, target);
+				target += faceSize;
+			}
+
+			fwrite(staging, 1, target - staging, file);
+		}
+
+		delete[] staging;
+
+		return closeFile(file);
+	}
+
+	bool saveMesh(const Mesh* mesh, const char* filename, MeshFormat format)
+	{
+		switch (format)
+		{
+		case FORMAT_PLY:
+			return savePly(mesh, filename);
+		case FORMAT_STL:
+			return saveStl(mesh, filename);
+		case FORMAT_GLB:
+			return saveGlb(mesh, filename);
+		}
+
+		return false;
+	}
+
+	bool saveHalves(const Mesh* left, const char* leftFile, const Mesh* right, const char* rightFile, MeshFormat format, ThreadPool* pool)
+	{
+		if (pool == nullptr)
+			pool = ThreadPool::getDefault();
+
+		const Mesh* meshes[2] = { left, right };
+		const char* filenames[2] = { leftFile, rightFile };
+		bool results[2] = { false, false };
+
+		pool->parallelFor(2, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i)
+				results[i] = saveMesh(meshes[i], filenames[i], format);
+		});
+
+		return results[0] && results[1];
+	}
+}
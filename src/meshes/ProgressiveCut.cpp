@@ -0,0 +1,169 @@
+#include "meshes/ProgressiveCut.h"
+
+#include "meshes/CutPlan.h"
+#include "meshes/MeshLods.h"
+#include "threading/ThreadPool.h"
+
+#include <condition_variable>
+
+namespace cut
+{
+	namespace
+	{
+		std::shared_ptr<const LodCutResult> cutLevel(const MeshLods* lods, int level, Vector3 planePoint, Vector3 planeNormal, float epsilon)
+		{
+			LodCutResult* result = new LodCutResult();
+			result->level = level;
+
+			CutOptions options;
+			options.epsilon = epsilon;
+
+			CutPlan plan;
+			const Mesh* mesh = lods->getLevel(level);
+
+			mesh->planCut(&plan, planePoint, planeNormal, options);
+			mesh->materialiseCut(&plan, &result->left, &result->right, options);
+
+			return std::shared_ptr<const LodCutResult>(result);
+		}
+	}
+
+	struct ProgressiveCut::RefineState
+	{
+		std::shared_ptr<const LodCutResult> result;
+
+		// The plane waiting for a full cut, if any, whether a task has been submitted to cut it,
+		// and the number of full cuts running
+		Vector3 pendingPoint;
+		Vector3 pendingNormal;
+		float pendingEpsilon;
+		bool hasPending;
+		bool taskQueued;
+		int cutting;
+
+		// Numbers the cut calls, so full cuts of planes that have since moved are thrown away
+		unsigned int latestRequest;
+		unsigned int pendingRequest;
+
+		std::mutex mutex;
+		std::condition_variable refined;
+	};
+
+	ProgressiveCut::ProgressiveCut(const MeshLods* lods, ThreadPool* pool)
+		: lods(lods), pool(pool != nullptr ? pool : ThreadPool::getDefault()), state(new RefineState())
+	{
+		state->pendingEpsilon = 0;
+		state->hasPending = false;
+		state->taskQueued = false;
+		state->cutting = 0;
+		state->latestRequest = 0;
+		state->pendingRequest = 0;
+	}
+
+	ProgressiveCut::~ProgressiveCut()
+	{
+		std::unique_lock<std::mutex> lock(state->mutex);
+
+		state->hasPending = false;
+
+		// A cut that's running will finish, unlike a task still queued behind busy threads
+		while (state->cutting > 0)
+			state->refined.wait(lock);
+	}
+
+	std::shared_ptr<const LodCutResult> ProgressiveCut::cut(Vector3 planePoint, Vector3 planeNormal, const CutOptions& options)
+	{
+		int previewLevel = lods->getLevelCount() - 1;
+
+		if (previewLevel < 0)
+			return nullptr;
+
+		std::shared_ptr<const LodCutResult> preview = cutLevel(lods, previewLevel, planePoint, planeNormal, options.epsilon);
+
+		std::lock_guard<std::mutex> lock(state->mutex);
+
+		state->result = preview;
+		state->latestRequest++;
+
+		// Without any simpler levels the preview is the full cut already
+		if (previewLevel == 0)
+		{
+			state->hasPending = false;
+			state->refined.notify_all();
+			return preview;
+		}
+
+		state->pendingPoint = planePoint;
+		state->pendingNormal = planeNormal;
+		state->pendingEpsilon = options.epsilon;
+		state->pendingRequest = state->latestRequest;
+		state->hasPending = true;
+
+		if (!state->taskQueued)
+		{
+			std::shared_ptr<RefineState> taskState = state;
+			const MeshLods* taskLods = lods;
+
+			state->taskQueued = true;
+
+			pool->submit([taskState, taskLods]()
+			{
+				std::unique_lock<std::mutex> taskLock(taskState->mutex);
+
+				refine(taskState.get(), taskLods, &taskLock);
+				taskState->taskQueued = false;
+			});
+		}
+
+		return preview;
+	}
+
+	std::shared_ptr<const LodCutResult> ProgressiveCut::getResult() const
+	{
+		std::lock_guard<std::mutex> lock(state->mutex);
+		return state->result;
+	}
+
+	bool ProgressiveCut::isRefined() const
+	{
+		std::lock_guard<std::mutex> lock(state->mutex);
+		return state->result != nullptr && state->result->level == 0;
+	}
+
+	void ProgressiveCut::wait()
+	{
+		std::unique_lock<std::mutex> lock(state->mutex);
+
+		// Take the waiting plane rather than rely on the task getting a thread
+		refine(state.get(), lods, &lock);
+
+		while (state->cutting > 0)
+			state->refined.wait(lock);
+	}
+
+	void ProgressiveCut::refine(RefineState* state, const MeshLods* lods, std::unique_lock<std::mutex>* lock)
+	{
+		// Keep going while cut is called again during a full cut, taking only the latest plane
+		while (state->hasPending)
+		{
+			Vector3 planePoint = state->pendingPoint;
+			Vector3 planeNormal = state->pendingNormal;
+			float epsilon = state->pendingEpsilon;
+			unsigned int request = state->pendingRequest;
+
+			state->hasPending = false;
+			state->cutting++;
+
+			lock->unlock();
+			std::shared_ptr<const LodCutResult> full = cutLevel(lods, 0, planePoint, planeNormal, epsilon);
+			lock->lock();
+
+			state->cutting--;
+
+			if (request == state->latestRequest)
+				state->result = full;
+
+			state->refined.notify_all();
+		}
+	}
+}
@@ -0,0 +1,381 @@
+#include "meshes/QuantizedMesh.h"
+
+#include "meshes/TriangleSplit.h"
+#include "memory/MemoryResource.h"
+
+#include <math.h>
+#include <string.h>
+#include <unordered_map>
+
+namespace cut
+{
+	namespace
+	{
+		const float QUANTIZED_MAX = 65535.0f;
+		const float NORMAL_MAX = 32767.0f;
+
+		unsigned short quantizeStep(float value)
+		{
+			if (value <= 0)
+				return 0;
+
+			if (value >= QUANTIZED_MAX)
+				return 65535;
+
+			return (unsigned short)(value + 0.5f);
+		}
+
+		float signOf(float value)
+		{
+			return value < 0 ? -1.0f : 1.0f;
+		}
+	}
+
+	QuantizedMesh::QuantizedMesh()
+		: positions(nullptr), normals(nullptr), indices(nullptr), vertexCount(0), indexCount(0)
+	{
+		boundsMin.x = boundsMin.y = boundsMin.z = 0;
+		step.x = step.y = step.z = 0;
+	}
+
+	QuantizedMesh::~QuantizedMesh()
+	{
+		release();
+	}
+
+	void QuantizedMesh::release()
+	{
+		delete[] positions;
+		delete[] normals;
+		delete[] indices;
+
+		positions = nullptr;
+		normals = nullptr;
+		indices = nullptr;
+
+		vertexCount = 0;
+		indexCount = 0;
+	}
+
+	void QuantizedMesh::quantize(const Mesh* mesh)
+	{
+		release();
+
+		vertexCount = mesh->vertexCount;
+		indexCount = mesh->indexCount;
+
+		Vector3 boundsMax = { 0, 0, 0 };
+
+		boundsMin = boundsMax;
+
+		if (vertexCount > 0)
+		{
+			boundsMin = mesh->vertices[0];
+			boundsMax = mesh->vertices[0];
+		}
+
+		for (int i = 1; i < vertexCount; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				if (mesh->vertices[i].data[j] < boundsMin.data[j])
+					boundsMin.data[j] = mesh->vertices[i].data[j];
+
+				if (mesh->vertices[i].data[j] > boundsMax.data[j])
+					boundsMax.data[j] = mesh->vertices[i].data[j];
+			}
+		}
+
+		for (int j = 0; j < 3; ++j)
+			step.data[j] = (boundsMax.data[j] - boundsMin.data[j]) / QUANTIZED_MAX;
+
+		positions = new unsigned short[vertexCount > 0 ? vertexCount * 3 : 1];
+
+		for (int i = 0; i < vertexCount; ++i)
+			for (int j = 0; j < 3; ++j)
+				positions[i * 3 + j] = step.data[j] > 0 ? quantizeStep((mesh->vertices[i].data[j] - boundsMin.data[j]) / step.data[j]) : 0;
+
+		if (mesh->vertexNormals != nullptr)
+		{
+			normals = new short[vertexCount > 0 ? vertexCount * 2 : 1];
+
+			for (int i = 0; i < vertexCount; ++i)
+				encodeNormal(&mesh->vertexNormals[i], &normals[i * 2]);
+		}
+
+		indices = new int[indexCount > 0 ? indexCount : 1];
+		memcpy(indices, mesh->indices, indexCount * sizeof(int));
+	}
+
+	void QuantizedMesh::dequantize(Mesh* mesh) const
+	{
+		MemoryResource* resource = mesh->getMemoryResource();
+
+		freeArray(resource, mesh->vertices);
+		freeArray(resource, mesh->vertexNormals);
+		freeArray(resource, mesh->texCoords);
+		freeArray(resource, mesh->indices);
+
+		mesh->clearAdjacency();
+		mesh->markChanged();
+
+		mesh->vertices = allocateArray<Vector3>(resource, vertexCount);
+		mesh->vertexNormals = normals != nullptr ? allocateArray<Vector3>(resource, vertexCount) : nullptr;
+		mesh->texCoords = nullptr;
+		mesh->indices = allocateArray<int>(resource, indexCount);
+
+		mesh->vertexCount = vertexCount;
+		mesh->indexCount = indexCount;
+		mesh->vertexCapacity = vertexCount;
+		mesh->indexCapacity = indexCount;
+
+		for (int i = 0; i < vertexCount; ++i)
+			getPosition(i, &mesh->vertices[i]);
+
+		if (normals != nullptr)
+		{
+			for (int i = 0; i < vertexCount; ++i)
+				decodeNormal(&normals[i * 2], &mesh->vertexNormals[i]);
+		}
+
+		memcpy(mesh->indices, indices, indexCount * sizeof(int));
+	}
+
+	void QuantizedMesh::getPosition(int vertex, Vector3* result) const
+	{
+		result->x = boundsMin.x + positions[vertex * 3] * step.x;
+		result->y = boundsMin.y + positions[vertex * 3 + 1] * step.y;
+		result->z = boundsMin.z + positions[vertex * 3 + 2] * step.z;
+	}
+
+	void QuantizedMesh::getNormal(int vertex, Vector3* result) const
+	{
+		decodeNormal(&normals[vertex * 2], result);
+	}
+
+	void QuantizedMesh::encodeNormal(const Vector3* normal, short* result)
+	{
+		// Project onto the octahedron |x| + |y| + |z| = 1, folding the lower half out over the corners
+		float sum = fabsf(normal->x) + fabsf(normal->y) + fabsf(normal->z);
+
+		if (sum == 0)
+		{
+			result[0] = 0;
+			result[1] = 0;
+			return;
+		}
+
+		float u = normal->x / sum;
+		float v = normal->y / sum;
+
+		if (normal->z < 0)
+		{
+			float foldedU = (1.0f - fabsf(v)) * signOf(u);
+			float foldedV = (1.0f - fabsf(u)) * signOf(v);
+
+			u = foldedU;
+			v = foldedV;
+		}
+
+		result[0] = (short)floorf(u * NORMAL_MAX + 0.5f);
+		result[1] = (short)floorf(v * NORMAL_MAX + 0.5f);
+	}
+
+	void QuantizedMesh::decodeNormal(const short* encoded, Vector3* result)
+	{
+		float u = encoded[0] / NORMAL_MAX;
+		float v = encoded[1] / NORMAL_MAX;
+
+		result->z = 1.0f - fabsf(u) - fabsf(v);
+
+		if (result->z < 0)
+		{
+			float unfoldedU = (1.0f - fabsf(v)) * signOf(u);
+			float unfoldedV = (1.0f - fabsf(u)) * signOf(v);
+
+			u = unfoldedU;
+			v = unfoldedV;
+		}
+
+		result->x = u;
+		result->y = v;
+
+		normalise3(result, result);
+	}
+
+	void QuantizedMesh::cut(QuantizedMesh* left, QuantizedMesh* right, Vector3 planePoint, Vector3 planeNormal, const CutOptions& options) const
+	{
+		int faceCount = indexCount / 3;
+
+		if (length3(&planeNormal) > 0)
+			normalise3(&planeNormal, &planeNormal);
+
+		// n.(boundsMin + q * step - planePoint) = (n * step).q + n.(boundsMin - planePoint), so
+		// scaling the normal by the step gives distances in mesh units straight from the steps
+		Vector3 quantizedNormal;
+		mul3(&planeNormal, &step, &quantizedNormal);
+
+		Vector3 offset;
+		sub3(&boundsMin, &planePoint, &offset);
+
+		float planeOffset = dot3(&planeNormal, &offset);
+
+		float* distances = new float[vertexCount > 0 ? vertexCount : 1];
+		PlaneSide* sides = new PlaneSide[vertexCount > 0 ? vertexCount : 1];
+
+		for (int i = 0; i < vertexCount; ++i)
+		{
+			const unsigned short* position = &positions[i * 3];
+
+			distances[i] = quantizedNormal.x * position[0] + quantizedNormal.y * position[1] + quantizedNormal.z * position[2] + planeOffset;
+			sides[i] = classifyDistance(distances[i], options.epsilon);
+		}
+
+		// At most two intersections a face, and each face splits into at most two on a side
+		int newVertexCount = vertexCount;
+		int newVertexMax = vertexCount + faceCount * 2;
+
+		unsigned short* newPositions = new unsigned short[newVertexMax > 0 ? newVertexMax * 3 : 1];
+		short* newNormals = normals != nullptr ? new short[newVertexMax > 0 ? newVertexMax * 2 : 1] : nullptr;
+
+		memcpy(newPositions, positions, vertexCount * 3 * sizeof(unsigned short));
+
+		if (normals != nullptr)
+			memcpy(newNormals, normals, vertexCount * 2 * sizeof(short));
+
+		int leftIndexCount = 0;
+		int* leftIndices = new int[faceCount > 0 ? faceCount * 6 : 1];
+
+		int rightIndexCount = 0;
+		int* rightIndices = new int[faceCount > 0 ? faceCount * 6 : 1];
+
+		std::unordered_map<unsigned long long, int> edgeVertices;
+
+		for (int i = 0; i < faceCount; ++i)
+		{
+			const int* face = &indices[i*3];
+
+			PlaneSide faceSides[3] = { sides[face[0]], sides[face[1]], sides[face[2]] };
+
+			TriangleSplit split;
+			splitTriangle(faceSides, &split);
+
+			// Faces lying in the plane go to the half they face into
+			if (split.sides[0] == SIDE_ON)
+			{
+				Vector3 corners[3], edge1, edge2, faceNormal;
+
+				for (int k = 0; k < 3; ++k)
+					getPosition(face[k], &corners[k]);
+
+				sub3(&corners[2], &corners[0], &edge1);
+				sub3(&corners[1], &corners[0], &edge2);
+				cross3(&edge1, &edge2, &faceNormal);
+
+				split.sides[0] = dot3(&faceNormal, &planeNormal) > 0 ? SIDE_RIGHT : SIDE_LEFT;
+			}
+
+			int splitVertices[SPLIT_EDGE + 3] = { face[0], face[1], face[2], -1, -1, -1 };
+
+			for (int j = 0; j < split.triangleCount; ++j)
+			{
+				for (int k = 0; k < 3; ++k)
+				{
+					int corner = split.corners[j][k];
+
+					if (splitVertices[corner] != -1)
+						continue;
+
+					int ia = face[corner - SPLIT_EDGE];
+					int ib = face[(corner - SPLIT_EDGE + 1) % 3];
+
+					// Always interpolate from the lower index so both faces agree on the point
+					if (ia > ib)
+					{
+						int temp = ia;
+						ia = ib;
+						ib = temp;
+					}
+
+					unsigned long long key = ((unsigned long long)ia << 32) | (unsigned int)ib;
+
+					std::unordered_map<unsigned long long, int>::iterator existing = edgeVertices.find(key);
+
+					if (existing != edgeVertices.end())
+					{
+						splitVertices[corner] = existing->second;
+						continue;
+					}
+
+					float t = distances[ia] / (distances[ia] - distances[ib]);
+					int intersectIndex = newVertexCount++;
+
+					for (int l = 0; l < 3; ++l)
+					{
+						float from = positions[ia * 3 + l];
+						float to = positions[ib * 3 + l];
+
+						newPositions[intersectIndex * 3 + l] = quantizeStep(from + (to - from) * t);
+					}
+
+					if (normals != nullptr)
+					{
+						Vector3 normalA, normalB, normal;
+
+						decodeNormal(&normals[ia * 2], &normalA);
+						decodeNormal(&normals[ib * 2], &normalB);
+						lerp3(&normalA, &normalB, t, &normal);
+						encodeNormal(&normal, &newNormals[intersectIndex * 2]);
+					}
+
+					edgeVertices[key] = intersectIndex;
+					splitVertices[corner] = intersectIndex;
+				}
+
+				int* targetIndices = split.sides[j] == SIDE_LEFT ? leftIndices : rightIndices;
+				int* targetCount = split.sides[j] == SIDE_LEFT ? &leftIndexCount : &rightIndexCount;
+
+				targetIndices[(*targetCount)++] = splitVertices[split.corners[j][0]];
+				targetIndices[(*targetCount)++] = splitVertices[split.corners[j][1]];
+				targetIndices[(*targetCount)++] = splitVertices[split.corners[j][2]];
+			}
+		}
+
+		QuantizedMesh* halves[2] = { left, right };
+		int* halfIndices[2] = { leftIndices, rightIndices };
+		int halfIndexCounts[2] = { leftIndexCount, rightIndexCount };
+
+		for (int i = 0; i < 2; ++i)
+		{
+			QuantizedMesh* half = halves[i];
+
+			half->release();
+
+			half->boundsMin = boundsMin;
+			half->step = step;
+
+			half->vertexCount = newVertexCount;
+			half->indexCount = halfIndexCounts[i];
+
+			half->positions = new unsigned short[newVertexCount > 0 ? newVertexCount * 3 : 1];
+			half->indices = new int[halfIndexCounts[i] > 0 ? halfIndexCounts[i] : 1];
+
+			memcpy(half->positions, newPositions, newVertexCount * 3 * sizeof(unsigned short));
+			memcpy(half->indices, halfIndices[i], halfIndexCounts[i] * sizeof(int));
+
+			if (normals != nullptr)
+			{
+				half->normals = new short[newVertexCount > 0 ? newVertexCount * 2 : 1];
+				memcpy(half->normals, newNormals, newVertexCount * 2 * sizeof(short));
+			}
+		}
+
+		delete[] newPositions;
+		delete[] newNormals;
+		delete[] leftIndices;
+		delete[] rightIndices;
+
+		delete[] distances;
+		delete[] sides;
+	}
+}
@@ -0,0 +1,50 @@
+#include "meshes/Mesh.h"
+
+#include "meshes/CutPlan.h"
+#include "meshes/Skinning.h"
+#include "meshes/TriangleSplit.h"
+
+namespace cut
+{
+	void Mesh::cutSkinned(Mesh* left, Mesh* right, const SkinWeights* skin, const Matrix4* palette, Vector3 planePoint, Vector3 planeNormal, const CutOptions& options) const
+	{
+		int faceCount = indexCount / 3;
+
+		// Distances are measured along a unit normal so that epsilon is in mesh units
+		if (length3(&planeNormal) > 0)
+			normalise3(&planeNormal, &planeNormal);
+
+		CutPlan plan;
+		plan.reserve(vertexCount, faceCount);
+
+		plan.planePoint = planePoint;
+		plan.planeNormal = planeNormal;
+		plan.vertexCount = vertexCount;
+		plan.faceCount = faceCount;
+
+		// Only the posed vertices are kept, as the halves are built from them
+		Vector3* posedVertices = new Vector3[vertexCount > 0 ? vertexCount : 1];
+		Vector3* posedNormals = new Vector3[vertexCount > 0 ? vertexCount : 1];
+
+		float planeDot = dot3(&planeNormal, &planePoint);
+
+		// Pose each vertex and classify it while it's still at hand, in one pass over the bind pose
+		for (int i = 0; i < vertexCount; ++i)
+		{
+			Vector3* posed = &posedVertices[i];
+
+			skinVertex(&vertices[i], &vertexNormals[i], &skin->boneIndices[i * SKIN_INFLUENCES], &skin->boneWeights[i * SKIN_INFLUENCES], palette, posed, &posedNormals[i]);
+
+			float distance = planeNormal.x * posed->x + planeNormal.y * posed->y + planeNormal.z * posed->z - planeDot;
+
+			plan.distances[i] = distance;
+			plan.vertexSides[i] = classifyDistance(distance, options.epsilon);
+		}
+
+		classifyFaces(&plan, posedVertices);
+		materialiseCutFrom(&plan, posedVertices, posedNormals, left, right, options);
+
+		delete[] posedVertices;
+		delete[] posedNormals;
+	}
+}
@@ -0,0 +1,430 @@
+#include "meshes/Contours.h"
+#include "meshes/Mesh.h"
+#include "maths/VectorBatch.h"
+#include "threading/ThreadPool.h"
+
+#include <math.h>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+namespace cut
+{
+	namespace
+	{
+		// Piece of a contour across one triangle, running from the edge where the surface
+		// rises through the plane to the edge where it falls back below it
+		struct Segment
+		{
+			unsigned long long startEdge;
+			unsigned long long endEdge;
+			Vector3 start;
+			Vector3 end;
+		};
+
+		// Contours for a run of consecutive layers, built by one task
+		struct LayerBatch
+		{
+			int firstLayer;
+			int endLayer;
+
+			std::vector<Vector3> points;
+			std::vector<int> polylineStarts;
+			std::vector<bool> polylineClosed;
+			std::vector<int> layerPolylineCounts;
+		};
+
+		unsigned long long edgeKey(int a, int b)
+		{
+			if (a > b)
+				return ((unsigned long long)b << 32) | (unsigned int)a;
+
+			return ((unsigned long long)a << 32) | (unsigned int)b;
+		}
+
+		// Always interpolate from the lower index, so both faces on an edge get the same point
+		void edgePoint(const Vector3* vertices, const float* heights, int a, int b, float layerHeight, Vector3* result)
+		{
+			int low = a < b ? a : b;
+			int high = a < b ? b : a;
+
+			float t = (layerHeight - heights[low]) / (heights[high] - heights[low]);
+			lerp3(&vertices[low], &vertices[high], t, result);
+		}
+
+		// Link the segments of one layer into polylines, using the edge each one starts and ends on
+		void chainSegments(const std::vector<Segment>& segments, LayerBatch* batch, std::unordered_map<unsigned long long, int>* startEdges, std::vector<int>* successors, std::vector<char>* state)
+		{
+			int segmentCount = (int)segments.size();
+
+			startEdges->clear();
+			successors->assign(segmentCount, -1);
+
+			// 1 = has a predecessor, 2 = emitted
+			state->assign(segmentCount, 0);
+
+			for (int i = 0; i < segmentCount; ++i)
+				(*startEdges)[segments[i].startEdge] = i;
+
+			for (int i = 0; i < segmentCount; ++i)
+			{
+				std::unordered_map<unsigned long long, int>::const_iterator next = startEdges->find(segments[i].endEdge);
+
+				if (next != startEdges->end())
+				{
+					(*successors)[i] = next->second;
+					(*state)[next->second] = 1;
+				}
+			}
+
+			int polylines = 0;
+
+			// Open polylines start at segments nothing leads into, then whatever is left is loops
+			for (int pass = 0; pass < 2; ++pass)
+			{
+				for (int first = 0; first < segmentCount; ++first)
+				{
+					if ((*state)[first] == 2 || (pass == 0 && (*state)[first] == 1))
+						continue;
+
+					batch->polylineStarts.push_back((int)batch->points.size());
+
+					int i = first;
+					int last = first;
+
+					while (i >= 0 && (*state)[i] != 2)
+					{
+						batch->points.push_back(segments[i].start);
+						(*state)[i] = 2;
+
+						last = i;
+						i = (*successors)[i];
+					}
+
+					bool closed = i == first;
+
+					if (!closed)
+						batch->points.push_back(segments[last].end);
+
+					batch->polylineClosed.push_back(closed);
+					polylines++;
+				}
+			}
+
+			batch->layerPolylineCounts.push_back(polylines);
+		}
+	}
+
+	Contours::Contours()
+		: points(nullptr), polylineStarts(nullptr), polylineClosed(nullptr), layerStarts(nullptr), pointCount(0), polylineCount(0), layerCount(0)
+	{
+
+	}
+
+	Contours::~Contours()
+	{
+		clear();
+	}
+
+	void Contours::clear()
+	{
+		delete[] points;
+		delete[] polylineStarts;
+		delete[] polylineClosed;
+		delete[] layerStarts;
+
+		points = nullptr;
+		polylineStarts = nullptr;
+		polylineClosed = nullptr;
+		layerStarts = nullptr;
+
+		pointCount = 0;
+		polylineCount = 0;
+		layerCount = 0;
+	}
+
+	void Mesh::slice(Contours* contours, Vector3 planePoint, Vector3 planeNormal, float spacing, int layerCount, ThreadPool* pool) const
+	{
+		contours->clear();
+
+		if (layerCount < 0 || spacing <= 0.0f)
+			layerCount = 0;
+
+		if (pool == nullptr)
+			pool = ThreadPool::getDefault();
+
+		normalise3(&planeNormal, &planeNormal);
+
+		int faceCount = indexCount / 3;
+
+		// Height of every vertex above the first layer
+		float* heights = new float[vertexCount];
+
+		pool->parallelFor(vertexCount, [&](int begin, int end)
+		{
+			planeDistanceBatch(&vertices[begin], &planeNormal, &planePoint, &heights[begin], end - begin);
+		});
+
+		// Range of layers each face might cross. This is conservative by a layer at each
+		// end, and the exact test is done when the segment is built.
+		int* firstLayers = new int[faceCount];
+		int* lastLayers = new int[faceCount];
+
+		pool->parallelFor(faceCount, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i)
+			{
+				float h1 = heights[indices[i*3 +0]];
+				float h2 = heights[indices[i*3 +1]];
+				float h3 = heights[indices[i*3 +2]];
+
+				float low = (h1 < h2 ? (h1 < h3 ? h1 : h3) : (h2 < h3 ? h2 : h3)) / spacing;
+				float high = (h1 > h2 ? (h1 > h3 ? h1 : h3) : (h2 > h3 ? h2 : h3)) / spacing;
+
+				if (high < -1.0f || low > (float)layerCount || !(low <= high))
+				{
+					firstLayers[i] = -1;
+					continue;
+				}
+
+				int first = low < 0.0f ? 0 : (int)floor(low);
+				int last = high >= (float)(layerCount - 1) ? layerCount - 1 : (int)floor(high) + 1;
+
+				firstLayers[i] = first;
+				lastLayers[i] = last < first ? -1 : last;
+			}
+		});
+
+		// Split the layers into batches that run in parallel
+		int batchCount = pool->getThreadCount() * 4;
+		if (batchCount > layerCount)
+			batchCount = layerCount;
+
+		std::vector<LayerBatch> batches(batchCount);
+		int* layerBatches = new int[layerCount + 1];
+
+		for (int b = 0; b < batchCount; ++b)
+		{
+			batches[b].firstLayer = (int)((long long)layerCount * b / batchCount);
+			batches[b].endLayer = (int)((long long)layerCount * (b + 1) / batchCount);
+
+			for (int k = batches[b].firstLayer; k < batches[b].endLayer; ++k)
+				layerBatches[k] = b;
+		}
+
+		// Give every batch the faces that overlap its layers, counting first so each part
+		// of the face range can write its own slice of the lists in parallel
+		int partCount = batchCount == 0 ? 0 : pool->getThreadCount() * 4;
+		if (partCount > faceCount)
+			partCount = faceCount;
+
+		std::vector<int> counts((size_t)partCount * batchCount + 1, 0);
+
+		pool->parallelFor(partCount, [&](int begin, int end)
+		{
+			for (int part = begin; part < end; ++part)
+			{
+				int* partCounts = &counts[(size_t)part * batchCount];
+
+				for (int i = (int)((long long)faceCount * part / partCount); i < (int)((long long)faceCount * (part + 1) / partCount); ++i)
+				{
+					if (firstLayers[i] < 0 || lastLayers[i] < 0)
+						continue;
+
+					for (int b = layerBatches[firstLayers[i]]; b <= layerBatches[lastLayers[i]]; ++b)
+						partCounts[b]++;
+				}
+			}
+		});
+
+		std::vector<int> batchStarts(batchCount + 1, 0);
+		int listSize = 0;
+
+		for (int b = 0; b < batchCount; ++b)
+		{
+			batchStarts[b] = listSize;
+
+			for (int part = 0; part < partCount; ++part)
+			{
+				int count = counts[(size_t)part * batchCount + b];
+				counts[(size_t)part * batchCount + b] = listSize;
+				listSize += count;
+			}
+		}
+
+		batchStarts[batchCount] = listSize;
+
+		int* faceLists = new int[listSize > 0 ? listSize : 1];
+
+		pool->parallelFor(partCount, [&](int begin, int end)
+		{
+			for (int part = begin; part < end; ++part)
+			{
+				int* partOffsets = &counts[(size_t)part * batchCount];
+
+				for (int i = (int)((long long)faceCount * part / partCount); i < (int)((long long)faceCount * (part + 1) / partCount); ++i)
+				{
+					if (firstLayers[i] < 0 || lastLayers[i] < 0)
+						continue;
+
+					for (int b = layerBatches[firstLayers[i]]; b <= layerBatches[lastLayers[i]]; ++b)
+						faceLists[partOffsets[b]++] = i;
+				}
+			}
+		});
+
+		// Sweep each batch's layers in order, keeping the set of faces spanning the current layer
+		pool->parallelFor(batchCount, [&](int begin, int end)
+		{
+			std::vector<int> bucketStarts;
+			std::vector<int> sorted;
+			std::vector<int> active;
+			std::vector<Segment> segments;
+			std::unordered_map<unsigned long long, int> startEdges;
+			std::vector<int> successors;
+			std::vector<char> state;
+
+			for (int b = begin; b < end; ++b)
+			{
+				LayerBatch* batch = &batches[b];
+				int batchLayers = batch->endLayer - batch->firstLayer;
+
+				const int* faces = &faceLists[batchStarts[b]];
+				int batchFaceCount = batchStarts[b + 1] - batchStarts[b];
+
+				// Counting sort by the first layer of the batch each face appears in
+				bucketStarts.assign(batchLayers + 1, 0);
+				sorted.resize(batchFaceCount);
+
+				for (int i = 0; i < batchFaceCount; ++i)
+				{
+					int first = firstLayers[faces[i]];
+					bucketStarts[(first > batch->firstLayer ? first : batch->firstLayer) - batch->firstLayer + 1]++;
+				}
+
+				for (int k = 0; k < batchLayers; ++k)
+					bucketStarts[k + 1] += bucketStarts[k];
+
+				for (int i = 0; i < batchFaceCount; ++i)
+				{
+					int first = firstLayers[faces[i]];
+					sorted[bucketStarts[(first > batch->firstLayer ? first : batch->firstLayer) - batch->firstLayer]++] = faces[i];
+				}
+
+				active.clear();
+				int nextSorted = 0;
+
+				for (int k = batch->firstLayer; k < batch->endLayer; ++k)
+				{
+					float layerHeight = k * spacing;
+
+					// Faces start being active at their first layer
+					while (nextSorted < batchFaceCount && (firstLayers[sorted[nextSorted]] <= k))
+						active.push_back(sorted[nextSorted++]);
+
+					segments.clear();
+
+					for (size_t a = 0; a < active.size();)
+					{
+						int face = active[a];
+
+						// Drop faces that are entirely below this layer
+						if (lastLayers[face] < k)
+						{
+							active[a] = active.back();
+							active.pop_back();
+							continue;
+						}
+
+						a++;
+
+						// Vertices exactly on the layer count as above it, so every crossed face
+						// has exactly one rising and one falling edge
+						int corners[3] = { indices[face*3 +0], indices[face*3 +1], indices[face*3 +2] };
+						bool above[3] = { heights[corners[0]] >= layerHeight, heights[corners[1]] >= layerHeight, heights[corners[2]] >= layerHeight };
+
+						if (above[0] == above[1] && above[1] == above[2])
+							continue;
+
+						Segment segment;
+
+						for (int e = 0; e < 3; ++e)
+						{
+							int u = corners[e];
+							int v = corners[(e + 1) % 3];
+
+							if (!above[e] && above[(e + 1) % 3])
+							{
+								segment.startEdge = edgeKey(u, v);
+								edgePoint(vertices, heights, u, v, layerHeight, &segment.start);
+							}
+							else if (above[e] && !above[(e + 1) % 3])
+							{
+								segment.endEdge = edgeKey(u, v);
+								edgePoint(vertices, heights, u, v, layerHeight, &segment.end);
+							}
+						}
+
+						segments.push_back(segment);
+					}
+
+					chainSegments(segments, batch, &startEdges, &successors, &state);
+				}
+			}
+		});
+
+		delete[] heights;
+		delete[] firstLayers;
+		delete[] lastLayers;
+		delete[] layerBatches;
+		delete[] faceLists;
+
+		// Join the batches together
+		int pointCount = 0;
+		int polylineCount = 0;
+
+		for (int b = 0; b < batchCount; ++b)
+		{
+			pointCount += (int)batches[b].points.size();
+			polylineCount += (int)batches[b].polylineStarts.size();
+		}
+
+		contours->points = new Vector3[pointCount > 0 ? pointCount : 1];
+		contours->polylineStarts = new int[polylineCount + 1];
+		contours->polylineClosed = new bool[polylineCount > 0 ? polylineCount : 1];
+		contours->layerStarts = new int[layerCount + 1];
+
+		contours->pointCount = pointCount;
+		contours->polylineCount = polylineCount;
+		contours->layerCount = layerCount;
+
+		int pointsWritten = 0;
+		int polylinesWritten = 0;
+		int layersWritten = 0;
+
+		for (int b = 0; b < batchCount; ++b)
+		{
+			const LayerBatch* batch = &batches[b];
+
+			if (!batch->points.empty())
+				memcpy(&contours->points[pointsWritten], &batch->points[0], batch->points.size() * sizeof(Vector3));
+
+			for (size_t i = 0; i < batch->polylineStarts.size(); ++i)
+			{
+				contours->polylineStarts[polylinesWritten + i] = batch->polylineStarts[i] + pointsWritten;
+				contours->polylineClosed[polylinesWritten + i] = batch->polylineClosed[i];
+			}
+
+			for (size_t k = 0; k < batch->layerPolylineCounts.size(); ++k)
+			{
+				contours->layerStarts[layersWritten++] = polylinesWritten;
+				polylinesWritten += batch->layerPolylineCounts[k];
+			}
+
+			pointsWritten += (int)batch->points.size();
+		}
+
+		contours->polylineStarts[polylineCount] = pointCount;
+		contours->layerStarts[layerCount] = polylineCount;
+	}
+}
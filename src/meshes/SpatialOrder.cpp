@@ -0,0 +1,155 @@
+#include "meshes/Mesh.h"
+
+#include "memory/MemoryResource.h"
+
+#include <algorithm>
+
+namespace cut
+{
+	namespace
+	{
+		// Bits of each coordinate in a Morton key, so three fit in 64 bits
+		const int MORTON_BITS = 21;
+
+		struct MortonKey
+		{
+			unsigned long long key;
+			int index;
+
+			bool operator<(const MortonKey& other) const { return key < other.key; }
+		};
+
+		// Spreads the low 21 bits of value out to every third bit
+		unsigned long long spreadBits(unsigned int value)
+		{
+			unsigned long long x = value & ((1u << MORTON_BITS) - 1);
+
+			x = (x | x << 32) & 0x1f00000000ffffull;
+			x = (x | x << 16) & 0x1f0000ff0000ffull;
+			x = (x | x << 8) & 0x100f00f00f00f00full;
+			x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+			x = (x | x << 2) & 0x1249249249249249ull;
+
+			return x;
+		}
+
+		// Scales a coordinate to the grid, clamped as centroids can round to just outside the box
+		unsigned int quantise(float value, float boundsMin, float scale)
+		{
+			float scaled = (value - boundsMin) * scale;
+			float maxValue = (float)((1 << MORTON_BITS) - 1);
+
+			return (unsigned int)(scaled < 0 ? 0 : (scaled > maxValue ? maxValue : scaled));
+		}
+
+		// Interleaves the coordinates of a point in the bounding box
+		unsigned long long getMortonKey(const Vector3* point, const Vector3* boundsMin, float scale)
+		{
+			unsigned int x = quantise(point->x, boundsMin->x, scale);
+			unsigned int y = quantise(point->y, boundsMin->y, scale);
+			unsigned int z = quantise(point->z, boundsMin->z, scale);
+
+			return spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2);
+		}
+
+		template <typename T>
+		void permuteArray(MemoryResource* resource, T** array, const MortonKey* order, int count)
+		{
+			if (*array == nullptr)
+				return;
+
+			T* sorted = allocateArray<T>(resource, count);
+
+			for (int i = 0; i < count; ++i)
+				sorted[i] = (*array)[order[i].index];
+
+			freeArray(resource, *array);
+			*array = sorted;
+		}
+	}
+
+	void Mesh::reorderSpatially()
+	{
+		int faceCount = indexCount / 3;
+
+		if (vertexCount == 0)
+			return;
+
+		Vector3 boundsMin = vertices[0];
+		Vector3 boundsMax = vertices[0];
+
+		for (int i = 1; i < vertexCount; ++i)
+		{
+			boundsMin.x = std::min(boundsMin.x, vertices[i].x);
+			boundsMin.y = std::min(boundsMin.y, vertices[i].y);
+			boundsMin.z = std::min(boundsMin.z, vertices[i].z);
+			boundsMax.x = std::max(boundsMax.x, vertices[i].x);
+			boundsMax.y = std::max(boundsMax.y, vertices[i].y);
+			boundsMax.z = std::max(boundsMax.z, vertices[i].z);
+		}
+
+		// The same scale on every axis, so the curve runs through cubes rather than stretched boxes
+		float extent = std::max(boundsMax.x - boundsMin.x, std::max(boundsMax.y - boundsMin.y, boundsMax.z - boundsMin.z));
+		float scale = extent > 0 ? (float)((1 << MORTON_BITS) - 1) / extent : 0;
+
+		// Vertices first, along the curve
+		MortonKey* order = new MortonKey[std::max(vertexCount, faceCount)];
+
+		for (int i = 0; i < vertexCount; ++i)
+		{
+			order[i].key = getMortonKey(&vertices[i], &boundsMin, scale);
+			order[i].index = i;
+		}
+
+		std::sort(order, order + vertexCount);
+
+		int* remap = new int[vertexCount];
+
+		for (int i = 0; i < vertexCount; ++i)
+			remap[order[i].index] = i;
+
+		permuteArray(resource, &vertices, order, vertexCount);
+		permuteArray(resource, &vertexNormals, order, vertexCount);
+		permuteArray(resource, &texCoords, order, vertexCount);
+
+		vertexCapacity = vertexCount;
+
+		// Then the faces, by the point on the curve of their centroids
+		for (int i = 0; i < faceCount; ++i)
+		{
+			const int* face = &indices[i*3];
+			Vector3 centroid;
+
+			for (int k = 0; k < 3; ++k)
+				centroid.data[k] = (vertices[remap[face[0]]].data[k] + vertices[remap[face[1]]].data[k] + vertices[remap[face[2]]].data[k]) * (1.0f / 3.0f);
+
+			order[i].key = getMortonKey(&centroid, &boundsMin, scale);
+			order[i].index = i;
+		}
+
+		std::sort(order, order + faceCount);
+
+		int* sortedIndices = allocateArray<int>(resource, faceCount * 3);
+
+		// Corners keep their order, so the winding is unchanged
+		for (int i = 0; i < faceCount; ++i)
+		{
+			const int* face = &indices[order[i].index * 3];
+
+			sortedIndices[i*3] = remap[face[0]];
+			sortedIndices[i*3 + 1] = remap[face[1]];
+			sortedIndices[i*3 + 2] = remap[face[2]];
+		}
+
+		freeArray(resource, indices);
+		indices = sortedIndices;
+		indexCount = faceCount * 3;
+		indexCapacity = indexCount;
+
+		delete[] order;
+		delete[] remap;
+
+		clearAdjacency();
+		markChanged();
+	}
+}
@@ -0,0 +1,637 @@
+#include "meshes/StreamingCut.h"
+#include "meshes/TriangleSplit.h"
+#include "maths/VectorBatch.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+
+namespace cut
+{
+	namespace
+	{
+		const char STREAM_MESH_MAGIC[4] = { 'S', 'M', 'S', 'H' };
+		const unsigned int STREAM_MESH_VERSION = 1;
+		const long long STREAM_MESH_HEADER_SIZE = 24;
+
+		const int PAGE_VERTICES = 4096;
+		const int MAX_POLYGON = 32;
+		const int LINE_LENGTH = 4096;
+
+		bool seekFile(FILE* file, long long offset)
+		{
+#ifdef _MSC_VER
+			return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+			return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+		}
+
+		unsigned long long hash(unsigned long long key)
+		{
+			key ^= key >> 33;
+			key *= 0xff51afd7ed558ccdULL;
+			key ^= key >> 33;
+			key *= 0xc4ceb9fe1a85ec53ULL;
+			key ^= key >> 33;
+
+			return key;
+		}
+	}
+
+	bool saveStreamMesh(const Mesh* mesh, const char* filename)
+	{
+		FILE* file = fopen(filename, "wb");
+
+		if (file == NULL)
+			return false;
+
+		unsigned int version = STREAM_MESH_VERSION;
+		long long vertexCount = mesh->vertexCount;
+		long long faceCount = mesh->indexCount / 3;
+
+		fwrite(STREAM_MESH_MAGIC, 1, 4, file);
+		fwrite(&version, sizeof(version), 1, file);
+		fwrite(&vertexCount, sizeof(vertexCount), 1, file);
+		fwrite(&faceCount, sizeof(faceCount), 1, file);
+
+		fwrite(mesh->vertices, sizeof(Vector3), mesh->vertexCount, file);
+		fwrite(mesh->indices, sizeof(int), (size_t)faceCount * 3, file);
+
+		bool success = ferror(file) == 0;
+
+		if (fclose(file) != 0)
+			success = false;
+
+		return success;
+	}
+
+	StreamingCutter::StreamingCutter(int chunkFaces, int windowSize, int cachePages)
+		: facesRead(0), leftFaceCount(0), rightFaceCount(0), leftVertexCount(0), rightVertexCount(0),
+		  chunkFaces(chunkFaces < MAX_POLYGON ? MAX_POLYGON : chunkFaces), windowSize(1), cachePages(cachePages < 1 ? 1 : cachePages),
+		  vertexSource(nullptr), error(nullptr)
+	{
+		// Remap windows are direct mapped, so round up to a power of two
+		while (this->windowSize < windowSize)
+			this->windowSize *= 2;
+
+		chunkIndices = new long long[this->chunkFaces * 3];
+		chunkPositions = new Vector3[this->chunkFaces * 3];
+		chunkDistances = new float[this->chunkFaces * 3];
+		binaryFaces = new unsigned int[this->chunkFaces * 3];
+
+		pages = new Vector3[this->cachePages * PAGE_VERTICES];
+		pageTags = new long long[this->cachePages];
+		pageUsed = new bool[this->cachePages];
+		pageSlots = nullptr;
+
+		left.file = nullptr;
+		right.file = nullptr;
+
+		left.remap = new RemapSlot[this->windowSize];
+		left.edges = new EdgeSlot[this->windowSize];
+		right.remap = new RemapSlot[this->windowSize];
+		right.edges = new EdgeSlot[this->windowSize];
+
+		lineBuffer = new char[LINE_LENGTH];
+	}
+
+	StreamingCutter::~StreamingCutter()
+	{
+		delete[] chunkIndices;
+		delete[] chunkPositions;
+		delete[] chunkDistances;
+		delete[] binaryFaces;
+
+		delete[] pages;
+		delete[] pageTags;
+		delete[] pageUsed;
+		delete[] pageSlots;
+
+		delete[] left.remap;
+		delete[] left.edges;
+		delete[] right.remap;
+		delete[] right.edges;
+
+		delete[] lineBuffer;
+	}
+
+	bool StreamingCutter::cut(const char* inputFile, const char* leftFile, const char* rightFile, Vector3 planePoint, Vector3 planeNormal, const CutOptions& options)
+	{
+		// Measure distances along a unit normal, as Mesh::cut does
+		if (length3(&planeNormal) > 0)
+			normalise3(&planeNormal, &planeNormal);
+
+		facesRead = 0;
+		leftFaceCount = 0;
+		rightFaceCount = 0;
+		leftVertexCount = 0;
+		rightVertexCount = 0;
+		vertexSource = NULL;
+		error = NULL;
+
+		FILE* input = fopen(inputFile, "rb");
+
+		if (input == NULL)
+		{
+			error = "couldn't open the input file";
+			return false;
+		}
+
+		// Work out the format from the first bytes
+		char magic[4] = { 0 };
+		bool binary = fread(magic, 1, 4, input) == 4 && memcmp(magic, STREAM_MESH_MAGIC, 4) == 0;
+
+		long long binaryFaceCount = 0;
+		std::string vertexFile;
+
+		if (binary)
+		{
+			unsigned int version = 0;
+
+			if (fread(&version, sizeof(version), 1, input) != 1 || version != STREAM_MESH_VERSION
+				|| fread(&vertexTotal, sizeof(vertexTotal), 1, input) != 1
+				|| fread(&binaryFaceCount, sizeof(binaryFaceCount), 1, input) != 1)
+			{
+				error = "the stream mesh header is invalid";
+			}
+			else
+			{
+				// Vertices are read through a second handle so the face stream stays sequential
+				vertexSource = fopen(inputFile, "rb");
+				vertexOffset = STREAM_MESH_HEADER_SIZE;
+
+				if (!seekFile(input, STREAM_MESH_HEADER_SIZE + vertexTotal * (long long)sizeof(Vector3)))
+					error = "couldn't seek to the faces";
+			}
+		}
+		else
+		{
+			// Obj faces can reference any vertex, so spill positions to a file we can seek in
+			vertexFile = std::string(leftFile) + ".vertices";
+
+			if (!convertObjVertices(input, vertexFile.c_str()))
+			{
+				error = "couldn't convert the obj vertices";
+			}
+			else
+			{
+				vertexSource = fopen(vertexFile.c_str(), "rb");
+				vertexOffset = 0;
+
+				if (!seekFile(input, 0))
+					error = "couldn't seek back to the start of the input";
+			}
+		}
+
+		if (error == NULL && vertexSource == NULL)
+			error = "couldn't open the vertices";
+
+		if (error == NULL)
+		{
+			// Reset the page cache
+			long long pageCount = (vertexTotal + PAGE_VERTICES - 1) / PAGE_VERTICES;
+
+			delete[] pageSlots;
+			pageSlots = new int[(size_t)pageCount + 1];
+
+			for (long long i = 0; i < pageCount; ++i)
+				pageSlots[i] = -1;
+
+			for (int i = 0; i < cachePages; ++i)
+			{
+				pageTags[i] = -1;
+				pageUsed[i] = false;
+			}
+
+			clockHand = 0;
+
+			// Open both halves whatever happens to the first, so closing doesn't depend on which failed
+			bool leftOpened = openHalf(&left, leftFile);
+			bool rightOpened = openHalf(&right, rightFile);
+
+			if (!leftOpened || !rightOpened)
+				error = "couldn't open the output files";
+		}
+
+		if (error == NULL)
+		{
+			long long objVerticesSeen = 0;
+			long long facesLeft = binaryFaceCount;
+
+			// Reading and fetching vertices set error rather than stopping partway through a chunk
+			while (error == NULL)
+			{
+				int faceCount = binary ? readBinaryFaces(input, facesLeft) : readObjFaces(input, &objVerticesSeen);
+
+				if (faceCount == 0)
+					break;
+
+				facesLeft -= faceCount;
+				facesRead += faceCount;
+
+				cutChunk(faceCount, planePoint, planeNormal, options.epsilon);
+			}
+
+			if (error == NULL && ferror(input) != 0)
+				error = "couldn't read the input file";
+
+			leftFaceCount = left.faceCount;
+			rightFaceCount = right.faceCount;
+			leftVertexCount = left.vertexCount;
+			rightVertexCount = right.vertexCount;
+		}
+
+		// Buffered writes can fail as late as the close
+		bool leftClosed = closeHalf(&left);
+		bool rightClosed = closeHalf(&right);
+
+		if (error == NULL && (!leftClosed || !rightClosed))
+			error = "couldn't write the output files";
+
+		if (vertexSource != NULL)
+			fclose(vertexSource);
+
+		vertexSource = NULL;
+		fclose(input);
+
+		if (!vertexFile.empty())
+			remove(vertexFile.c_str());
+
+		return error == NULL;
+	}
+
+	const char* StreamingCutter::getError() const
+	{
+		return error;
+	}
+
+	bool StreamingCutter::openHalf(Half* half, const char* filename)
+	{
+		half->file = fopen(filename, "w");
+		half->vertexCount = 0;
+		half->faceCount = 0;
+
+		for (int i = 0; i < windowSize; ++i)
+		{
+			half->remap[i].source = -1;
+			half->edges[i].a = -1;
+		}
+
+		if (half->file == NULL)
+			return false;
+
+		setvbuf(half->file, NULL, _IOFBF, 1 << 20);
+
+		return true;
+	}
+
+	bool StreamingCutter::closeHalf(Half* half)
+	{
+		if (half->file == NULL)
+			return true;
+
+		bool success = ferror(half->file) == 0;
+
+		if (fclose(half->file) != 0)
+			success = false;
+
+		half->file = NULL;
+
+		return success;
+	}
+
+	const Vector3* StreamingCutter::fetchVertex(long long index)
+	{
+		long long page = index / PAGE_VERTICES;
+		int slot = pageSlots[page];
+
+		if (slot < 0)
+		{
+			// Evict with the clock algorithm, giving recently used pages a second chance
+			while (pageUsed[clockHand])
+			{
+				pageUsed[clockHand] = false;
+				clockHand = (clockHand + 1) % cachePages;
+			}
+
+			slot = clockHand;
+			clockHand = (clockHand + 1) % cachePages;
+
+			if (pageTags[slot] >= 0)
+				pageSlots[pageTags[slot]] = -1;
+
+			long long first = page * PAGE_VERTICES;
+			long long count = vertexTotal - first < PAGE_VERTICES ? vertexTotal - first : PAGE_VERTICES;
+
+			Vector3* target = &pages[slot * PAGE_VERTICES];
+
+			if (!seekFile(vertexSource, vertexOffset + first * (long long)sizeof(Vector3))
+				|| fread(target, sizeof(Vector3), (size_t)count, vertexSource) != (size_t)count)
+			{
+				// Keep the page defined for the rest of the chunk, the cut fails once it's done
+				memset(target, 0, sizeof(Vector3) * (size_t)count);
+				error = "couldn't read the vertices";
+			}
+
+			pageTags[slot] = page;
+			pageSlots[page] = slot;
+		}
+
+		pageUsed[slot] = true;
+
+		return &pages[slot * PAGE_VERTICES + index % PAGE_VERTICES];
+	}
+
+	long long StreamingCutter::emitVertex(Half* half, long long index)
+	{
+		// Reuse the output vertex if it was written recently, otherwise write it again
+		RemapSlot* slot = &half->remap[hash(index) & (windowSize - 1)];
+
+		if (slot->source != index)
+		{
+			const Vector3* v = fetchVertex(index);
+			fprintf(half->file, "v %.9g %.9g %.9g\n", v->x, v->y, v->z);
+
+			slot->source = index;
+			slot->output = ++half->vertexCount;
+		}
+
+		return slot->output;
+	}
+
+	long long StreamingCutter::emitIntersection(Half* half, long long a, long long b, float t)
+	{
+		// Both faces sharing a crossing edge use the same intersection vertex
+		EdgeSlot* slot = &half->edges[hash(a * 0x9e3779b97f4a7c15ULL + b) & (windowSize - 1)];
+
+		if (slot->a != a || slot->b != b)
+		{
+			// Copy the first point, as fetching the second can evict its page
+			Vector3 from = *fetchVertex(a);
+			Vector3 intersection;
+			lerp3(&from, fetchVertex(b), t, &intersection);
+
+			fprintf(half->file, "v %.9g %.9g %.9g\n", intersection.x, intersection.y, intersection.z);
+
+			slot->a = a;
+			slot->b = b;
+			slot->output = ++half->vertexCount;
+		}
+
+		return slot->output;
+	}
+
+	void StreamingCutter::emitFace(Half* half, long long a, long long b, long long c)
+	{
+		fprintf(half->file, "f %lld %lld %lld\n", a, b, c);
+		half->faceCount++;
+	}
+
+	bool StreamingCutter::convertObjVertices(FILE* input, const char* vertexFile)
+	{
+		FILE* output = fopen(vertexFile, "wb");
+
+		if (output == NULL)
+			return false;
+
+		Vector3* buffer = chunkPositions;
+		int buffered = 0;
+		bool success = true;
+
+		vertexTotal = 0;
+
+		while (success && fgets(lineBuffer, LINE_LENGTH, input) != NULL)
+		{
+			if (lineBuffer[0] != 'v' || lineBuffer[1] != ' ')
+				continue;
+
+			Vector3* v = &buffer[buffered];
+
+			if (sscanf(lineBuffer, "v %f %f %f", &v->x, &v->y, &v->z) != 3)
+				v->x = v->y = v->z = 0.0f;
+
+			// Keep numbering in step with the file even if a vertex is malformed
+			vertexTotal++;
+
+			if (++buffered == chunkFaces * 3)
+			{
+				success = fwrite(buffer, sizeof(Vector3), buffered, output) == (size_t)buffered;
+				buffered = 0;
+			}
+		}
+
+		if (success)
+			success = fwrite(buffer, sizeof(Vector3), buffered, output) == (size_t)buffered;
+
+		if (ferror(input) != 0 || ferror(output) != 0)
+			success = false;
+
+		if (fclose(output) != 0)
+			success = false;
+
+		return success;
+	}
+
+	int StreamingCutter::readObjFaces(FILE* input, long long* vertexCountSoFar)
+	{
+		int faceCount = 0;
+		long long polygon[MAX_POLYGON];
+
+		// Stop while there's still room for the largest polygon
+		while (faceCount <= chunkFaces - (MAX_POLYGON - 2) && fgets(lineBuffer, LINE_LENGTH, input) != NULL)
+		{
+			if (lineBuffer[0] == 'v' && lineBuffer[1] == ' ')
+			{
+				(*vertexCountSoFar)++;
+				continue;
+			}
+
+			if (lineBuffer[0] != 'f' || !isspace((unsigned char)lineBuffer[1]))
+				continue;
+
+			// A face that doesn't fit in the line buffer would lose its last corners
+			if (strchr(lineBuffer, '\n') == NULL && !feof(input))
+			{
+				error = "a face line is too long";
+				return 0;
+			}
+
+			// Take the position index from each v, v/t, v//n or v/t/n corner
+			int corners = 0;
+			bool valid = true;
+			char* cursor = lineBuffer + 1;
+
+			for (;;)
+			{
+				char* end;
+				long long index = strtoll(cursor, &end, 10);
+
+				if (end == cursor)
+					break;
+
+				// Chunks only leave room for polygons up to MAX_POLYGON corners
+				if (corners == MAX_POLYGON)
+				{
+					error = "a polygon has too many corners";
+					return 0;
+				}
+
+				// Negative indices are relative to the vertices read so far
+				index = index < 0 ? *vertexCountSoFar + index : index - 1;
+
+				if (index < 0 || index >= vertexTotal)
+					valid = false;
+
+				polygon[corners++] = index;
+
+				cursor = end;
+				while (*cursor != '\0' && !isspace((unsigned char)*cursor))
+					cursor++;
+			}
+
+			if (!valid || corners < 3)
+				continue;
+
+			// Fan triangulate, keeping the winding from the file
+			for (int i = 1; i + 1 < corners; ++i)
+			{
+				chunkIndices[faceCount * 3 + 0] = polygon[0];
+				chunkIndices[faceCount * 3 + 1] = polygon[i];
+				chunkIndices[faceCount * 3 + 2] = polygon[i + 1];
+				faceCount++;
+			}
+		}
+
+		return faceCount;
+	}
+
+	int StreamingCutter::readBinaryFaces(FILE* input, long long facesLeft)
+	{
+		int faceCount = facesLeft < chunkFaces ? (int)facesLeft : chunkFaces;
+
+		unsigned int* faces = binaryFaces;
+		int requested = faceCount;
+		faceCount = (int)fread(faces, sizeof(unsigned int) * 3, faceCount, input);
+
+		// The header promised these faces, so running out early means the file is cut short
+		if (faceCount < requested)
+		{
+			error = "the stream mesh ends early";
+			return 0;
+		}
+
+		int validFaces = 0;
+
+		for (int i = 0; i < faceCount; ++i)
+		{
+			unsigned int a = faces[i * 3 + 0];
+			unsigned int b = faces[i * 3 + 1];
+			unsigned int c = faces[i * 3 + 2];
+
+			if (a >= vertexTotal || b >= vertexTotal || c >= vertexTotal)
+				continue;
+
+			chunkIndices[validFaces * 3 + 0] = a;
+			chunkIndices[validFaces * 3 + 1] = b;
+			chunkIndices[validFaces * 3 + 2] = c;
+			validFaces++;
+		}
+
+		// A chunk of only invalid faces isn't the end of the file
+		if (validFaces == 0 && faceCount > 0 && facesLeft > faceCount)
+			return readBinaryFaces(input, facesLeft - faceCount);
+
+		return validFaces;
+	}
+
+	void StreamingCutter::cutChunk(int faceCount, Vector3 planePoint, Vector3 planeNormal, float epsilon)
+	{
+		int cornerCount = faceCount * 3;
+
+		// Gather positions through the page cache and classify them all at once
+		for (int i = 0; i < cornerCount; ++i)
+			chunkPositions[i] = *fetchVertex(chunkIndices[i]);
+
+		planeDistanceBatch(chunkPositions, &planeNormal, &planePoint, chunkDistances, cornerCount);
+
+		for (int i = 0; i < faceCount; ++i)
+		{
+			const long long* face = &chunkIndices[i * 3];
+			const float* distance = &chunkDistances[i * 3];
+
+			// Same classification as Mesh::cut: in front of the plane is left
+			PlaneSide sides[3] =
+			{
+				classifyDistance(distance[0], epsilon),
+				classifyDistance(distance[1], epsilon),
+				classifyDistance(distance[2], epsilon)
+			};
+
+			TriangleSplit split;
+			splitTriangle(sides, &split);
+
+			if (split.triangleCount == 1)
+			{
+				PlaneSide side = split.sides[0];
+
+				// Faces lying in the plane go to the half they face into
+				if (side == SIDE_ON)
+				{
+					const Vector3* positions = &chunkPositions[i * 3];
+					Vector3 edge1, edge2, faceNormal;
+
+					sub3(&positions[2], &positions[0], &edge1);
+					sub3(&positions[1], &positions[0], &edge2);
+					cross3(&edge1, &edge2, &faceNormal);
+
+					side = dot3(&faceNormal, &planeNormal) > 0 ? SIDE_RIGHT : SIDE_LEFT;
+				}
+
+				Half* half = side == SIDE_LEFT ? &left : &right;
+
+				long long a = emitVertex(half, face[0]);
+				long long b = emitVertex(half, face[1]);
+				long long c = emitVertex(half, face[2]);
+
+				emitFace(half, a, b, c);
+				continue;
+			}
+
+			for (int j = 0; j < split.triangleCount; ++j)
+			{
+				Half* half = split.sides[j] == SIDE_LEFT ? &left : &right;
+				long long output[3];
+
+				for (int k = 0; k < 3; ++k)
+				{
+					int corner = split.corners[j][k];
+
+					if (corner < SPLIT_EDGE)
+					{
+						output[k] = emitVertex(half, face[corner]);
+						continue;
+					}
+
+					int ea = corner - SPLIT_EDGE;
+					int eb = (ea + 1) % 3;
+
+					// Interpolate from the lower index, so shared edges give identical points from either face
+					if (face[ea] > face[eb])
+					{
+						int temp = ea;
+						ea = eb;
+						eb = temp;
+					}
+
+					float t = distance[ea] / (distance[ea] - distance[eb]);
+
+					output[k] = emitIntersection(half, face[ea], face[eb], t);
+				}
+
+				emitFace(half, output[0], output[1], output[2]);
+			}
+		}
+	}
+}
@@ -0,0 +1,239 @@
+#include "meshes/VertexCacheOptimiser.h"
+#include "meshes/Mesh.h"
+
+#include <string.h>
+
+namespace cut
+{
+	VertexCacheOptimiser::VertexCacheOptimiser(int cacheSize)
+		: cacheSize(cacheSize < 3 ? 3 : cacheSize),
+		  vertexCapacity(0), adjacencyStarts(nullptr), liveCounts(nullptr), cacheTimes(nullptr), remap(nullptr), vectorScratch(nullptr), texCoordScratch(nullptr),
+		  indexCapacity(0), adjacency(nullptr), candidates(nullptr), deadEnds(nullptr), output(nullptr), emitted(nullptr)
+	{
+
+	}
+
+	VertexCacheOptimiser::~VertexCacheOptimiser()
+	{
+		delete[] adjacencyStarts;
+		delete[] liveCounts;
+		delete[] cacheTimes;
+		delete[] remap;
+		delete[] vectorScratch;
+		delete[] texCoordScratch;
+
+		delete[] adjacency;
+		delete[] candidates;
+		delete[] deadEnds;
+		delete[] output;
+		delete[] emitted;
+	}
+
+	void VertexCacheOptimiser::optimise(Mesh* mesh)
+	{
+		mesh->clearAdjacency();
+		mesh->markChanged();
+
+		optimiseFaces(mesh->indices, mesh->indexCount, mesh->vertexCount);
+
+		mesh->vertexCount = optimiseVertices(mesh->indices, mesh->indexCount, mesh->vertexCount, mesh->vertices, mesh->vertexNormals, mesh->texCoords);
+	}
+
+	void VertexCacheOptimiser::optimiseFaces(int* indices, int indexCount, int vertexCount)
+	{
+		int faceCount = indexCount / 3;
+
+		if (faceCount == 0 || vertexCount == 0)
+			return;
+
+		reserve(vertexCount, indexCount);
+
+		// Build the faces around each vertex with a counting sort, using cacheTimes as the fill cursor
+		memset(liveCounts, 0, vertexCount * sizeof(int));
+
+		for (int i = 0; i < faceCount * 3; ++i)
+			++liveCounts[indices[i]];
+
+		adjacencyStarts[0] = 0;
+
+		for (int i = 0; i < vertexCount; ++i)
+		{
+			adjacencyStarts[i + 1] = adjacencyStarts[i] + liveCounts[i];
+			cacheTimes[i] = adjacencyStarts[i];
+		}
+
+		for (int i = 0; i < faceCount * 3; ++i)
+			adjacency[cacheTimes[indices[i]]++] = i / 3;
+
+		memset(cacheTimes, 0, vertexCount * sizeof(int));
+		memset(emitted, 0, faceCount * sizeof(bool));
+
+		// Start with every vertex out of the cache
+		int time = cacheSize + 1;
+		int outputCount = 0;
+		int deadEndCount = 0;
+		int cursor = 0;
+		int fanning = 0;
+
+		while (fanning >= 0)
+		{
+			int candidateCount = 0;
+
+			// Emit every remaining face around the fanning vertex
+			for (int i = adjacencyStarts[fanning]; i < adjacencyStarts[fanning + 1]; ++i)
+			{
+				int face = adjacency[i];
+
+				if (emitted[face])
+					continue;
+
+				emitted[face] = true;
+
+				for (int j = 0; j < 3; ++j)
+				{
+					int vertex = indices[face * 3 + j];
+
+					output[outputCount++] = vertex;
+					deadEnds[deadEndCount++] = vertex;
+					candidates[candidateCount++] = vertex;
+
+					--liveCounts[vertex];
+
+					if (time - cacheTimes[vertex] > cacheSize)
+						cacheTimes[vertex] = time++;
+				}
+			}
+
+			// Fan next around the oldest candidate that will still be in the cache when its faces are emitted
+			fanning = -1;
+			int bestPriority = -1;
+
+			for (int i = 0; i < candidateCount; ++i)
+			{
+				int vertex = candidates[i];
+
+				if (liveCounts[vertex] <= 0)
+					continue;
+
+				int priority = 0;
+
+				if (time - cacheTimes[vertex] + 2 * liveCounts[vertex] <= cacheSize)
+					priority = time - cacheTimes[vertex];
+
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					fanning = vertex;
+				}
+			}
+
+			// Dead end, so go back to a recently used vertex, or failing that the next unfinished one
+			while (fanning == -1 && deadEndCount > 0)
+			{
+				int vertex = deadEnds[--deadEndCount];
+
+				if (liveCounts[vertex] > 0)
+					fanning = vertex;
+			}
+
+			while (fanning == -1 && cursor < vertexCount)
+			{
+				if (liveCounts[cursor] > 0)
+					fanning = cursor;
+				else
+					++cursor;
+			}
+		}
+
+		memcpy(indices, output, outputCount * sizeof(int));
+	}
+
+	int VertexCacheOptimiser::optimiseVertices(int* indices, int indexCount, int vertexCount, Vector3* vertices, Vector3* normals, Vector2* texCoords)
+	{
+		reserve(vertexCount, indexCount);
+
+		memset(remap, 0xff, vertexCount * sizeof(int));
+
+		int usedCount = 0;
+
+		for (int i = 0; i < indexCount; ++i)
+		{
+			int vertex = indices[i];
+
+			if (remap[vertex] < 0)
+				remap[vertex] = usedCount++;
+
+			indices[i] = remap[vertex];
+		}
+
+		// Move the attributes through the scratch buffers
+		if (vertices != nullptr)
+		{
+			for (int i = 0; i < vertexCount; ++i)
+				if (remap[i] >= 0)
+					vectorScratch[remap[i]] = vertices[i];
+
+			memcpy(vertices, vectorScratch, usedCount * sizeof(Vector3));
+		}
+
+		if (normals != nullptr)
+		{
+			for (int i = 0; i < vertexCount; ++i)
+				if (remap[i] >= 0)
+					vectorScratch[remap[i]] = normals[i];
+
+			memcpy(normals, vectorScratch, usedCount * sizeof(Vector3));
+		}
+
+		if (texCoords != nullptr)
+		{
+			for (int i = 0; i < vertexCount; ++i)
+				if (remap[i] >= 0)
+					texCoordScratch[remap[i]] = texCoords[i];
+
+			memcpy(texCoords, texCoordScratch, usedCount * sizeof(Vector2));
+		}
+
+		return usedCount;
+	}
+
+	void VertexCacheOptimiser::reserve(int vertexCount, int indexCount)
+	{
+		if (vertexCount > vertexCapacity)
+		{
+			delete[] adjacencyStarts;
+			delete[] liveCounts;
+			delete[] cacheTimes;
+			delete[] remap;
+			delete[] vectorScratch;
+			delete[] texCoordScratch;
+
+			// Grow geometrically so a run of slightly bigger cuts doesn't reallocate every time
+			vertexCapacity = vertexCount > vertexCapacity * 3 / 2 ? vertexCount : vertexCapacity * 3 / 2;
+
+			adjacencyStarts = new int[vertexCapacity + 1];
+			liveCounts = new int[vertexCapacity];
+			cacheTimes = new int[vertexCapacity];
+			remap = new int[vertexCapacity];
+			vectorScratch = new Vector3[vertexCapacity];
+			texCoordScratch = new Vector2[vertexCapacity];
+		}
+
+		if (indexCount > indexCapacity)
+		{
+			delete[] adjacency;
+			delete[] candidates;
+			delete[] deadEnds;
+			delete[] output;
+			delete[] emitted;
+
+			indexCapacity = indexCount > indexCapacity * 3 / 2 ? indexCount : indexCapacity * 3 / 2;
+
+			adjacency = new int[indexCapacity];
+			candidates = new int[indexCapacity];
+			deadEnds = new int[indexCapacity];
+			output = new int[indexCapacity];
+			emitted = new bool[indexCapacity];
+		}
+	}
+}
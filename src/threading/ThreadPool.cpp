@@ -0,0 +1,157 @@
+#include "threading/ThreadPool.h"
+
+#include <atomic>
+#include <memory>
+
+namespace cut
+{
+	namespace
+	{
+		// State shared by the batches of one parallelFor call. Helpers that start after
+		// the call has finished find no batches left, so they never touch the body.
+		struct ParallelJob
+		{
+			std::atomic<int> nextBatch;
+			std::atomic<int> batchesDone;
+			int batchCount;
+			int count;
+			const std::function<void(int, int)>* body;
+
+			std::mutex mutex;
+			std::condition_variable finished;
+
+			void run()
+			{
+				for (;;)
+				{
+					int batch = nextBatch++;
+
+					if (batch >= batchCount)
+						return;
+
+					int begin = (int)((long long)count * batch / batchCount);
+					int end = (int)((long long)count * (batch + 1) / batchCount);
+
+					(*body)(begin, end);
+
+					if (++batchesDone == batchCount)
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						finished.notify_all();
+					}
+				}
+			}
+		};
+
+		std::once_flag defaultPoolFlag;
+		ThreadPool* defaultPool = nullptr;
+	}
+
+	ThreadPool::ThreadPool(int threadCount)
+		: stopping(false)
+	{
+		if (threadCount <= 0)
+			threadCount = (int)std::thread::hardware_concurrency();
+
+		if (threadCount <= 0)
+			threadCount = 1;
+
+		for (int i = 0; i < threadCount; ++i)
+			threads.push_back(std::thread(&ThreadPool::workerMain, this));
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+
+		taskAvailable.notify_all();
+
+		for (size_t i = 0; i < threads.size(); ++i)
+			threads[i].join();
+	}
+
+	void ThreadPool::submit(const std::function<void()>& task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.push_back(task);
+		}
+
+		taskAvailable.notify_one();
+	}
+
+	void ThreadPool::parallelFor(int count, const std::function<void(int begin, int end)>& body)
+	{
+		if (count <= 0)
+			return;
+
+		int threadCount = getThreadCount();
+
+		// A few batches per thread evens out uneven work
+		int batchCount = threadCount == 1 ? 1 : threadCount * 4;
+		if (batchCount > count)
+			batchCount = count;
+
+		if (batchCount == 1)
+		{
+			body(0, count);
+			return;
+		}
+
+		std::shared_ptr<ParallelJob> job(new ParallelJob());
+		job->nextBatch = 0;
+		job->batchesDone = 0;
+		job->batchCount = batchCount;
+		job->count = count;
+		job->body = &body;
+
+		int helpers = threadCount < batchCount - 1 ? threadCount : batchCount - 1;
+
+		for (int i = 0; i < helpers; ++i)
+			submit([job]() { job->run(); });
+
+		job->run();
+
+		std::unique_lock<std::mutex> lock(job->mutex);
+		while (job->batchesDone < batchCount)
+			job->finished.wait(lock);
+	}
+
+	int ThreadPool::getThreadCount() const
+	{
+		return (int)threads.size();
+	}
+
+	ThreadPool* ThreadPool::getDefault()
+	{
+		std::call_once(defaultPoolFlag, []() { defaultPool = new ThreadPool(); });
+
+		return defaultPool;
+	}
+
+	void ThreadPool::workerMain()
+	{
+		for (;;)
+		{
+			std::function<void()> task;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+
+				while (!stopping && tasks.empty())
+					taskAvailable.wait(lock);
+
+				if (stopping && tasks.empty())
+					return;
+
+				task = tasks.front();
+				tasks.pop_front();
+			}
+
+			task();
+		}
+	}
+}
@@ -0,0 +1,557 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark/Timer.h"
+#include "maths/Vector.h"
+#include "memory/MemoryResource.h"
+#include "meshes/Mesh.h"
+#include "meshes/MeshLoader.h"
+#include "meshes/MeshWriter.h"
+#include "threading/BoundedQueue.h"
+#include "threading/ThreadPool.h"
+
+using namespace cut;
+
+// Headless batch slicer. Each line of the job file is an obj file followed by any number of
+// planes, each a point and a normal as six numbers:
+//
+//     # comment
+//     models/rock.obj   0 0 0  0 1 0   0 0 0  1 0 0
+//     "models/big rock.obj"   0 0.5 0  0 1 0
+//
+// Every mesh is cut by each plane in turn, so n planes give up to 2^n pieces, and each piece
+// with faces is written to the output directory as <name>_<job>_<piece>.<format>.
+//
+// Jobs go through three stages joined by bounded queues: reading the files on one thread,
+// which keeps the disk streaming, parsing and cutting on one thread per core, and writing on
+// one thread. Each stage only gets a queue's length ahead of the next, so memory stays bounded
+// however many jobs there are.
+
+struct Plane
+{
+	Vector3 point;
+	Vector3 normal;
+};
+
+struct SliceJob
+{
+	int number;
+	std::string filename;
+	std::vector<Plane> planes;
+
+	char* text;
+	std::vector<Mesh*> pieces;
+	int triangleCount;
+	bool failed;
+};
+
+struct PipelineStats
+{
+	std::atomic<int> meshCount;
+	std::atomic<int> failedCount;
+	std::atomic<long long> triangleCount;
+	std::atomic<int> pieceCount;
+
+	// Seconds each stage spent working rather than waiting on its queues, over all its threads
+	std::mutex timeMutex;
+	double readTime;
+	double cutTime;
+	double writeTime;
+};
+
+struct PipelineSettings
+{
+	const char* outputDirectory;
+	MeshFormat format;
+	const char* extension;
+	CutOptions options;
+};
+
+// Function declarations
+bool readJobs(const char* filename, std::vector<SliceJob*>* jobs);
+bool parsePath(const char** line, std::string* path);
+void readStage(std::vector<SliceJob*>* jobs, BoundedQueue<SliceJob*>* output, PipelineStats* stats);
+void cutStage(BoundedQueue<SliceJob*>* input, BoundedQueue<SliceJob*>* output, const PipelineSettings* settings, PipelineStats* stats);
+void writeStage(BoundedQueue<SliceJob*>* input, const PipelineSettings* settings, PipelineStats* stats);
+void cutPieces(SliceJob* job, const CutOptions& options);
+void compactVertices(Mesh* mesh, int* remap);
+void getStem(const char* filename, std::string* stem);
+void freeJob(SliceJob* job);
+void addTime(PipelineStats* stats, double* time, double seconds);
+
+int main(int argc, char** argv)
+{
+	const char* jobFile = nullptr;
+	int cutThreads = 0;
+	int queueLength = 0;
+
+	PipelineSettings settings;
+	settings.outputDirectory = ".";
+	settings.format = FORMAT_PLY;
+	settings.extension = "ply";
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+			settings.outputDirectory = argv[++i];
+		else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+		{
+			settings.extension = argv[++i];
+
+			if (strcmp(settings.extension, "ply") == 0)
+				settings.format = FORMAT_PLY;
+			else if (strcmp(settings.extension, "stl") == 0)
+				settings.format = FORMAT_STL;
+			else if (strcmp(settings.extension, "glb") == 0)
+				settings.format = FORMAT_GLB;
+			else
+			{
+				fprintf(stderr, "Unknown format %s\n", settings.extension);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			cutThreads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--queue") == 0 && i + 1 < argc)
+			queueLength = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--epsilon") == 0 && i + 1 < argc)
+			settings.options.epsilon = (float)atof(argv[++i]);
+		else if (argv[i][0] != '-' && jobFile == nullptr)
+			jobFile = argv[i];
+		else
+		{
+			printf("Usage: %s jobfile [--output dir] [--format ply|stl|glb] [--threads n] [--queue n] [--epsilon e]\n", argv[0]);
+			return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+		}
+	}
+
+	if (jobFile == nullptr)
+	{
+		printf("Usage: %s jobfile [--output dir] [--format ply|stl|glb] [--threads n] [--queue n] [--epsilon e]\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<SliceJob*> jobs;
+
+	if (!readJobs(jobFile, &jobs))
+	{
+		fprintf(stderr, "Couldn't read job file %s\n", jobFile);
+		return 1;
+	}
+
+	if (cutThreads <= 0)
+		cutThreads = (int)std::thread::hardware_concurrency();
+
+	if (cutThreads <= 0)
+		cutThreads = 1;
+
+	// Enough for every cutting thread to have a job waiting, and no more
+	if (queueLength <= 0)
+		queueLength = cutThreads * 2;
+
+	PipelineStats stats;
+	stats.meshCount = 0;
+	stats.failedCount = 0;
+	stats.triangleCount = 0;
+	stats.pieceCount = 0;
+	stats.readTime = 0;
+	stats.cutTime = 0;
+	stats.writeTime = 0;
+
+	BoundedQueue<SliceJob*> readQueue(queueLength);
+	BoundedQueue<SliceJob*> writeQueue(queueLength);
+
+	std::mutex doneMutex;
+	std::condition_variable stageDone;
+	int cutThreadsRunning = cutThreads;
+	bool writeDone = false;
+
+	// Every stage thread blocks on its queues for as long as the pipeline runs, so the pool has
+	// exactly one thread for each rather than sharing the default pool
+	ThreadPool pool(cutThreads + 2);
+
+	double startTime = getTime();
+
+	pool.submit([&]()
+	{
+		readStage(&jobs, &readQueue, &stats);
+	});
+
+	for (int i = 0; i < cutThreads; ++i)
+	{
+		pool.submit([&]()
+		{
+			cutStage(&readQueue, &writeQueue, &settings, &stats);
+
+			// The last cutting thread to finish tells the writer there's nothing more coming
+			std::lock_guard<std::mutex> lock(doneMutex);
+
+			if (--cutThreadsRunning == 0)
+				writeQueue.close();
+		});
+	}
+
+	pool.submit([&]()
+	{
+		writeStage(&writeQueue, &settings, &stats);
+
+		std::lock_guard<std::mutex> lock(doneMutex);
+		writeDone = true;
+		stageDone.notify_all();
+	});
+
+	{
+		std::unique_lock<std::mutex> lock(doneMutex);
+
+		while (!writeDone)
+			stageDone.wait(lock);
+	}
+
+	double totalTime = getTime() - startTime;
+
+	int meshCount = stats.meshCount;
+	long long triangleCount = stats.triangleCount;
+
+	printf("%d meshes (%d failed), %lld triangles, %d pieces written in %.3f s\n", meshCount, (int)stats.failedCount, triangleCount, (int)stats.pieceCount, totalTime);
+	printf("%.1f meshes/s, %.0f triangles/s on %d cutting threads\n", totalTime > 0 ? meshCount / totalTime : 0.0, totalTime > 0 ? triangleCount / totalTime : 0.0, cutThreads);
+	printf("busy time: read %.3f s, parse+cut %.3f s (%.0f%% of %d threads), write %.3f s\n", stats.readTime, stats.cutTime,
+		totalTime > 0 ? stats.cutTime * 100.0 / (totalTime * cutThreads) : 0.0, cutThreads, stats.writeTime);
+
+	return stats.failedCount > 0 ? 2 : 0;
+}
+
+bool readJobs(const char* filename, std::vector<SliceJob*>* jobs)
+{
+	char* text = readTextFile(filename, nullptr);
+
+	if (text == nullptr)
+		return false;
+
+	int lineNumber = 0;
+	char* line = text;
+
+	while (line != nullptr && *line != '\0')
+	{
+		char* next = strchr(line, '\n');
+
+		if (next != nullptr)
+			*next++ = '\0';
+
+		lineNumber++;
+
+		const char* cursor = line;
+		line = next;
+
+		while (*cursor == ' ' || *cursor == '\t')
+			cursor++;
+
+		if (*cursor == '\0' || *cursor == '\r' || *cursor == '#')
+			continue;
+
+		SliceJob* job = new SliceJob();
+		job->number = (int)jobs->size();
+		job->text = nullptr;
+		job->triangleCount = 0;
+		job->failed = false;
+
+		if (!parsePath(&cursor, &job->filename))
+		{
+			fprintf(stderr, "%s:%d: unterminated quote\n", filename, lineNumber);
+			delete job;
+			continue;
+		}
+
+		// Planes until the numbers run out
+		for (;;)
+		{
+			Plane plane;
+			int length = 0;
+
+			if (sscanf(cursor, " %f %f %f %f %f %f%n", &plane.point.x, &plane.point.y, &plane.point.z, &plane.normal.x, &plane.normal.y, &plane.normal.z, &length) != 6)
+				break;
+
+			job->planes.push_back(plane);
+			cursor += length;
+		}
+
+		while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')
+			cursor++;
+
+		if (*cursor != '\0' && *cursor != '#')
+			fprintf(stderr, "%s:%d: ignoring \"%s\", planes are six numbers each\n", filename, lineNumber, cursor);
+
+		jobs->push_back(job);
+	}
+
+	delete[] text;
+
+	return true;
+}
+
+// Takes a path from the start of the line, in double quotes if it has spaces in it
+bool parsePath(const char** line, std::string* path)
+{
+	const char* start = *line;
+	const char* end;
+
+	if (*start == '"')
+	{
+		start++;
+		end = strchr(start, '"');
+
+		if (end == nullptr)
+			return false;
+
+		*line = end + 1;
+	}
+	else
+	{
+		end = start;
+
+		while (*end != '\0' && *end != ' ' && *end != '\t' && *end != '\r')
+			end++;
+
+		*line = end;
+	}
+
+	path->assign(start, end - start);
+
+	return true;
+}
+
+void readStage(std::vector<SliceJob*>* jobs, BoundedQueue<SliceJob*>* output, PipelineStats* stats)
+{
+	for (size_t i = 0; i < jobs->size(); ++i)
+	{
+		SliceJob* job = (*jobs)[i];
+
+		double start = getTime();
+		job->text = readTextFile(job->filename.c_str(), nullptr);
+		addTime(stats, &stats->readTime, getTime() - start);
+
+		// Failures go on down the pipeline too, so they're counted in one place
+		if (job->text == nullptr)
+			job->failed = true;
+
+		output->push(job);
+	}
+
+	output->close();
+}
+
+void cutStage(BoundedQueue<SliceJob*>* input, BoundedQueue<SliceJob*>* output, const PipelineSettings* settings, PipelineStats* stats)
+{
+	SliceJob* job;
+
+	while (input->pop(&job))
+	{
+		if (!job->failed)
+		{
+			double start = getTime();
+
+			Mesh* mesh = new Mesh();
+			mesh->parseObj(job->text);
+
+			delete[] job->text;
+			job->text = nullptr;
+
+			if (mesh->indexCount > 0)
+			{
+				mesh->calculateNormals();
+
+				job->triangleCount = mesh->indexCount / 3;
+				job->pieces.push_back(mesh);
+
+				cutPieces(job, settings->options);
+			}
+			else
+			{
+				job->failed = true;
+				delete mesh;
+			}
+
+			addTime(stats, &stats->cutTime, getTime() - start);
+		}
+
+		output->push(job);
+	}
+}
+
+void writeStage(BoundedQueue<SliceJob*>* input, const PipelineSettings* settings, PipelineStats* stats)
+{
+	SliceJob* job;
+	std::string stem;
+	std::vector<char> filename;
+
+	while (input->pop(&job))
+	{
+		double start = getTime();
+
+		getStem(job->filename.c_str(), &stem);
+		filename.resize(strlen(settings->outputDirectory) + stem.size() + strlen(settings->extension) + 32);
+
+		for (size_t i = 0; i < job->pieces.size() && !job->failed; ++i)
+		{
+			sprintf(&filename[0], "%s/%s_%d_%d.%s", settings->outputDirectory, stem.c_str(), job->number, (int)i, settings->extension);
+
+			if (saveMesh(job->pieces[i], &filename[0], settings->format))
+				stats->pieceCount++;
+			else
+			{
+				fprintf(stderr, "Couldn't write %s\n", &filename[0]);
+				job->failed = true;
+			}
+		}
+
+		if (job->failed)
+		{
+			fprintf(stderr, "Job %d (%s) failed\n", job->number, job->filename.c_str());
+			stats->failedCount++;
+		}
+		else
+		{
+			stats->meshCount++;
+			stats->triangleCount += job->triangleCount;
+		}
+
+		freeJob(job);
+
+		addTime(stats, &stats->writeTime, getTime() - start);
+	}
+}
+
+// Cuts every piece by each plane in turn, dropping halves with no faces
+void cutPieces(SliceJob* job, const CutOptions& options)
+{
+	std::vector<Mesh*> cutPieces;
+	std::vector<int> remap;
+
+	for (size_t i = 0; i < job->planes.size(); ++i)
+	{
+		cutPieces.clear();
+
+		for (size_t j = 0; j < job->pieces.size(); ++j)
+		{
+			Mesh* left = new Mesh();
+			Mesh* right = new Mesh();
+
+			job->pieces[j]->cut(left, right, job->planes[i].point, job->planes[i].normal, options);
+			delete job->pieces[j];
+
+			int vertexCount = left->vertexCount > right->vertexCount ? left->vertexCount : right->vertexCount;
+
+			if ((int)remap.size() < vertexCount)
+				remap.resize(vertexCount);
+
+			if (left->indexCount > 0)
+			{
+				compactVertices(left, &remap[0]);
+				cutPieces.push_back(left);
+			}
+			else
+				delete left;
+
+			if (right->indexCount > 0)
+			{
+				compactVertices(right, &remap[0]);
+				cutPieces.push_back(right);
+			}
+			else
+				delete right;
+		}
+
+		job->pieces.swap(cutPieces);
+	}
+}
+
+template <typename T>
+void compactArray(MemoryResource* resource, T** array, const int* remap, int vertexCount, int usedCount)
+{
+	if (*array == nullptr)
+		return;
+
+	T* compacted = allocateArray<T>(resource, usedCount);
+
+	for (int i = 0; i < vertexCount; ++i)
+		if (remap[i] >= 0)
+			compacted[remap[i]] = (*array)[i];
+
+	freeArray(resource, *array);
+	*array = compacted;
+}
+
+// Both halves of a cut keep every vertex of the mesh they came from, so without this each
+// plane would double the vertices carried by the pieces. Keeps only the vertices the faces
+// use, in their order. remap needs room for a number per vertex.
+void compactVertices(Mesh* mesh, int* remap)
+{
+	int vertexCount = mesh->vertexCount;
+
+	for (int i = 0; i < vertexCount; ++i)
+		remap[i] = -1;
+
+	for (int i = 0; i < mesh->indexCount; ++i)
+		remap[mesh->indices[i]] = 0;
+
+	int usedCount = 0;
+
+	for (int i = 0; i < vertexCount; ++i)
+		if (remap[i] >= 0)
+			remap[i] = usedCount++;
+
+	if (usedCount == vertexCount)
+		return;
+
+	MemoryResource* resource = mesh->getMemoryResource();
+
+	compactArray(resource, &mesh->vertices, remap, vertexCount, usedCount);
+	compactArray(resource, &mesh->vertexNormals, remap, vertexCount, usedCount);
+	compactArray(resource, &mesh->texCoords, remap, vertexCount, usedCount);
+
+	for (int i = 0; i < mesh->indexCount; ++i)
+		mesh->indices[i] = remap[mesh->indices[i]];
+
+	// Corners keep their places, so any adjacency is still right
+	mesh->vertexCount = usedCount;
+	mesh->vertexCapacity = usedCount;
+	mesh->markChanged();
+}
+
+// The file name without its directory or extension
+void getStem(const char* filename, std::string* stem)
+{
+	const char* start = filename;
+
+	for (const char* c = filename; *c != '\0'; ++c)
+		if (*c == '/' || *c == '\\')
+			start = c + 1;
+
+	const char* end = strrchr(start, '.');
+
+	if (end == nullptr || end == start)
+		end = start + strlen(start);
+
+	stem->assign(start, end - start);
+}
+
+void freeJob(SliceJob* job)
+{
+	for (size_t i = 0; i < job->pieces.size(); ++i)
+		delete job->pieces[i];
+
+	delete[] job->text;
+	delete job;
+}
+
+void addTime(PipelineStats* stats, double* time, double seconds)
+{
+	std::lock_guard<std::mutex> lock(stats->timeMutex);
+	*time += seconds;
+}